@@ -0,0 +1,583 @@
+/*BEGIN_LEGAL
+  Intel Open Source License
+
+  Copyright (c) 2016 Intel Corporation. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.  Redistributions
+  in binary form must reproduce the above copyright notice, this list of
+  conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.  Neither the name of
+  the Intel Corporation nor the names of its contributors may be used to
+  endorse or promote products derived from this software without
+  specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+  ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  END_LEGAL */
+
+/** Create a custom output stream that moves compression off the writing
+    thread.  Output is collected into fixed-size blocks; each filled block
+    is handed to a pool of Pin internal threads that compress it as an
+    independent gzip member or bzip2 stream.  Compressed blocks are written
+    to the file in submission order, so the result is an ordinary
+    concatenated .gz/.bz2 file that gzip, bzip2 and the intel_*_istream
+    readers decode as one stream.
+
+    Memory is bounded by the number of blocks: when all of them are queued
+    or being compressed, the writer waits for one to be written out.
+
+    The compression threads belong to an intel_async_pool.  A stream
+    either starts a pool of its own or shares one with other streams, so
+    that a tool writing a stream per application thread does not start
+    compression threads per stream.
+
+    Data reaches the file a block at a time; sync() does not force out a
+    partial block.  close() must be called before the process exits.  A
+    PrepareForFini callback stops the compression threads of all pools;
+    anything written after that is compressed in the writing thread.
+
+    Optionally a block index (see intel_block_index.hpp) is written next to
+    the file so readers can seek and decompress blocks in parallel. */
+
+#ifndef INTEL_ASYNC_OSTREAM_HPP
+#define INTEL_ASYNC_OSTREAM_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <stdio.h>
+#include "pin.H"
+#include "zlib.h"
+#include "bzlib.h"
+#include "intel_zipstream.hpp"
+#include "intel_block_index.hpp"
+
+#define ASYNC_OSTREAM_BLOCK_SIZE 0x100000 // 1MB
+#define ASYNC_OSTREAM_MAX_BLOCKS 8
+#define ASYNC_OSTREAM_MAX_WORKERS 16
+
+class intel_async_ostreambuf;
+
+// Pin internal threads compressing the queued blocks of any number of
+// intel_async_ostreambufs.  Every queued block is one work item, taken in
+// the order the blocks were queued.
+class intel_async_pool {
+public:
+    explicit intel_async_pool(UINT32 numWorkers = 1) : exiting(false)
+    {
+        if (numWorkers > ASYNC_OSTREAM_MAX_WORKERS)
+            numWorkers = ASYNC_OSTREAM_MAX_WORKERS;
+
+        PIN_MutexInit(&mutex);
+        PIN_SemaphoreInit(&workReady);
+
+        for (UINT32 i = 0; i < numWorkers; i++)
+        {
+            PIN_THREAD_UID uid;
+            if (PIN_SpawnInternalThread(Worker, this, 0, &uid) == INVALID_THREADID)
+                break;
+            workerUids.push_back(uid);
+        }
+        if (!workerUids.empty())
+            Register(this);
+    }
+
+    ~intel_async_pool()
+    {
+        stop();
+        PIN_SemaphoreFini(&workReady);
+        PIN_MutexFini(&mutex);
+    }
+
+    UINT32 size() const { return UINT32(workerUids.size()); }
+
+    // Queue a block of 'sb' for compression.  Returns false once the pool
+    // is stopping (or has no threads); the caller compresses it itself.
+    bool queue(intel_async_ostreambuf *sb)
+    {
+        PIN_MutexLock(&mutex);
+        if (exiting || workerUids.empty())
+        {
+            PIN_MutexUnlock(&mutex);
+            return false;
+        }
+        work.push_back(sb);
+        PIN_SemaphoreSet(&workReady);
+        PIN_MutexUnlock(&mutex);
+        return true;
+    }
+
+    // Let the threads finish the queued blocks, then terminate them.
+    // Called from PrepareForFini while application threads may still
+    // write, and possibly again from the destructor.
+    void stop()
+    {
+        PIN_MutexLock(&mutex);
+        if (exiting || workerUids.empty())
+        {
+            PIN_MutexUnlock(&mutex);
+            return;
+        }
+        exiting = true;
+        PIN_SemaphoreSet(&workReady);
+        std::vector<PIN_THREAD_UID> uids = workerUids;
+        PIN_MutexUnlock(&mutex);
+
+        Unregister(this);
+        for (size_t i = 0; i < uids.size(); i++)
+            PIN_WaitForThreadTermination(uids[i], PIN_INFINITE_TIMEOUT, NULL);
+
+        PIN_MutexLock(&mutex);
+        workerUids.clear();
+        PIN_MutexUnlock(&mutex);
+    }
+
+private:
+    // Protects work, workerUids and exiting.
+    PIN_MUTEX mutex;
+    PIN_SEMAPHORE workReady; // a block was queued, or exiting was set
+    std::list<intel_async_ostreambuf *> work;
+    std::vector<PIN_THREAD_UID> workerUids;
+    bool exiting;
+
+    static VOID Worker(VOID *arg);
+
+    // Pools with running threads, stopped from PrepareForFini.
+    struct REGISTRY {
+        PIN_LOCK lock;
+        std::list<intel_async_pool *> pools;
+        bool finiAdded;
+        REGISTRY() : finiAdded(false) { PIN_InitLock(&lock); }
+    };
+
+    static REGISTRY &Registry()
+    {
+        static REGISTRY registry;
+        return registry;
+    }
+
+    static void Register(intel_async_pool *pool)
+    {
+        REGISTRY &reg = Registry();
+        PIN_GetLock(&reg.lock, PIN_ThreadId() + 1);
+        reg.pools.push_back(pool);
+        if (!reg.finiAdded)
+        {
+            PIN_AddPrepareForFiniFunction(PrepareForFini, NULL);
+            reg.finiAdded = true;
+        }
+        PIN_ReleaseLock(&reg.lock);
+    }
+
+    static void Unregister(intel_async_pool *pool)
+    {
+        REGISTRY &reg = Registry();
+        PIN_GetLock(&reg.lock, PIN_ThreadId() + 1);
+        reg.pools.remove(pool);
+        PIN_ReleaseLock(&reg.lock);
+    }
+
+    static VOID PrepareForFini(VOID *v)
+    {
+        REGISTRY &reg = Registry();
+        PIN_GetLock(&reg.lock, PIN_ThreadId() + 1);
+        std::list<intel_async_pool *> pools = reg.pools;
+        PIN_ReleaseLock(&reg.lock);
+
+        for (std::list<intel_async_pool *>::iterator it = pools.begin();
+             it != pools.end(); it++)
+            (*it)->stop();
+    }
+};
+
+// custom output streambuf that compresses blocks on internal threads, overwrites existing file
+class intel_async_ostreambuf : public std::streambuf {
+public:
+    // Compress on a pool of 'numWorkers' threads of this stream's own.
+    intel_async_ostreambuf(const std::string &name,
+                           intel_zipstream::CompressionPolicy policy,
+                           UINT32 numWorkers = 1,
+                           UINT32 blockSize = ASYNC_OSTREAM_BLOCK_SIZE,
+                           UINT32 maxBlocks = ASYNC_OSTREAM_MAX_BLOCKS,
+                           bool writeIndex = false)
+        : filePointer(NULL), fileName(name), compressionPolicy(policy),
+          blockSize(blockSize), current(NULL), nextSeq(0), nextWrite(0),
+          pool(NULL), ownPool(true), writeIndex(writeIndex),
+          compressedOffset(0), uncompressedOffset(0),
+          error(false), constructionComplete(false)
+    {
+        if (numWorkers > ASYNC_OSTREAM_MAX_WORKERS)
+            numWorkers = ASYNC_OSTREAM_MAX_WORKERS;
+        if (maxBlocks < numWorkers + 1)
+            maxBlocks = numWorkers + 1;
+        if (open(maxBlocks))
+            pool = new intel_async_pool(numWorkers);
+    }
+
+    // Compress on a pool shared with other streams; 'pool' must outlive
+    // the stream.
+    intel_async_ostreambuf(intel_async_pool &pool,
+                           const std::string &name,
+                           intel_zipstream::CompressionPolicy policy,
+                           UINT32 blockSize = ASYNC_OSTREAM_BLOCK_SIZE,
+                           UINT32 maxBlocks = ASYNC_OSTREAM_MAX_BLOCKS,
+                           bool writeIndex = false)
+        : filePointer(NULL), fileName(name), compressionPolicy(policy),
+          blockSize(blockSize), current(NULL), nextSeq(0), nextWrite(0),
+          pool(&pool), ownPool(false), writeIndex(writeIndex),
+          compressedOffset(0), uncompressedOffset(0),
+          error(false), constructionComplete(false)
+    {
+        open(maxBlocks < 2 ? 2 : maxBlocks);
+    }
+
+    ~intel_async_ostreambuf()
+    {
+        close();
+        if (ownPool)
+            delete pool;
+        PIN_SemaphoreFini(&blockWritten);
+        PIN_MutexFini(&mutex);
+    }
+
+    bool constructionCompleted(void) { return constructionComplete; }
+
+    // Write out the partial block, stop the workers of an own pool and
+    // close the file.
+    bool close()
+    {
+        if (!filePointer)
+            return !error;
+        submit();
+        stopWorkers();
+        if (fclose(filePointer) != 0)
+            error = true;
+        filePointer = NULL;
+        setp(0, 0);
+        if (writeIndex &&
+            !intel_write_block_index(fileName + INTEL_BLOCK_INDEX_SUFFIX,
+                                     compressionPolicy, index))
+            error = true;
+        return !error;
+    }
+
+    // Wait until every submitted block is written, then terminate the
+    // threads of an own pool.  Later output is compressed inline.
+    void stopWorkers()
+    {
+        PIN_MutexLock(&mutex);
+        while (nextWrite != nextSeq)
+            waitFor(&blockWritten);
+        PIN_MutexUnlock(&mutex);
+        if (ownPool && pool)
+            pool->stop();
+    }
+
+protected:
+    // called when the current block is full
+    virtual int_type overflow(int_type c)
+    {
+        if (!filePointer)
+            return traits_type::eof();
+        submit();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    // Output is written a whole block at a time.
+    virtual int sync() { return 0; }
+
+private:
+    friend class intel_async_pool;
+
+    struct BLOCK {
+        enum STATE { FREE, FILLING, QUEUED, COMPRESSING, DONE };
+        std::vector<char> in;
+        std::vector<char> out;
+        UINT32 inSize;
+        UINT32 outSize;
+        UINT64 seq;
+        STATE state;
+    };
+
+    FILE *filePointer;
+    std::string fileName;
+    intel_zipstream::CompressionPolicy compressionPolicy;
+    UINT32 blockSize;
+    std::vector<BLOCK> blocks;
+    BLOCK *current;
+    UINT64 nextSeq;   // sequence number of the next block submitted
+    UINT64 nextWrite; // sequence number of the next block to write
+    intel_async_pool *pool;
+    bool ownPool;
+    bool writeIndex;
+    intel_block_index index;
+    UINT64 compressedOffset;
+    UINT64 uncompressedOffset;
+
+    // Protects the block states, nextSeq, nextWrite, error, the index and
+    // the file.
+    PIN_MUTEX mutex;
+    PIN_SEMAPHORE blockWritten; // a block was written and is free again
+    bool error;
+    bool constructionComplete;
+
+    // Wait for 'sem' to be set; 'mutex' must be held and is held on return.
+    void waitFor(PIN_SEMAPHORE *sem)
+    {
+        PIN_SemaphoreClear(sem);
+        PIN_MutexUnlock(&mutex);
+        PIN_SemaphoreWait(sem);
+        PIN_MutexLock(&mutex);
+    }
+
+    // Open the file and set up 'maxBlocks' blocks.
+    bool open(UINT32 maxBlocks)
+    {
+        PIN_MutexInit(&mutex);
+        PIN_SemaphoreInit(&blockWritten);
+
+        filePointer = fopen(fileName.c_str(), "wb");
+        if (!filePointer)
+            return false;
+
+        blocks.resize(maxBlocks);
+        for (UINT32 i = 0; i < maxBlocks; i++)
+        {
+            blocks[i].in.resize(blockSize);
+            blocks[i].state = BLOCK::FREE;
+        }
+        blocks[0].state = BLOCK::FILLING;
+        startFilling(&blocks[0]);
+        constructionComplete = true;
+        return true;
+    }
+
+    // Make 'block' the put area; its state is already FILLING.
+    void startFilling(BLOCK *block)
+    {
+        current = block;
+        setp(&block->in[0], &block->in[0] + blockSize);
+    }
+
+    // Hand the current block off for compression and start a new one.
+    void submit()
+    {
+        UINT32 size = UINT32(pptr() - pbase());
+        if (size == 0)
+            return;
+        current->inSize = size;
+
+        // Once the pool is stopping it takes no more blocks; compress this
+        // one here, after the blocks the pool still has are written.  The
+        // block is no longer QUEUED while waiting so no worker takes it.
+        PIN_MutexLock(&mutex);
+        current->seq = nextSeq++;
+        current->state = BLOCK::QUEUED;
+        if (!pool || !pool->queue(this))
+        {
+            current->state = BLOCK::FILLING;
+            while (nextWrite != current->seq)
+                waitFor(&blockWritten);
+            error |= !compress(current);
+            writeOut(current);
+            nextWrite++;
+            PIN_MutexUnlock(&mutex);
+            startFilling(current);
+            return;
+        }
+
+        BLOCK *next = NULL;
+        while (!(next = findBlock(BLOCK::FREE)))
+            waitFor(&blockWritten);
+        next->state = BLOCK::FILLING;
+        PIN_MutexUnlock(&mutex);
+        startFilling(next);
+    }
+
+    BLOCK *findBlock(BLOCK::STATE state)
+    {
+        for (size_t i = 0; i < blocks.size(); i++)
+            if (blocks[i].state == state)
+                return &blocks[i];
+        return NULL;
+    }
+
+    BLOCK *findDone(UINT64 seq)
+    {
+        for (size_t i = 0; i < blocks.size(); i++)
+            if (blocks[i].state == BLOCK::DONE && blocks[i].seq == seq)
+                return &blocks[i];
+        return NULL;
+    }
+
+    // Compress block->in into block->out as a self-contained member.
+    bool compress(BLOCK *block)
+    {
+        bool ok = true;
+        if (compressionPolicy == intel_zipstream::ZLibCompression)
+        {
+            z_stream strm;
+            memset(&strm, 0, sizeof(strm));
+            // windowBits 15+16 selects the gzip wrapper.
+            if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                             15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                block->outSize = 0;
+                return false;
+            }
+            block->out.resize(deflateBound(&strm, block->inSize));
+            strm.next_in = reinterpret_cast<Bytef *>(&block->in[0]);
+            strm.avail_in = block->inSize;
+            strm.next_out = reinterpret_cast<Bytef *>(&block->out[0]);
+            strm.avail_out = block->out.size();
+            if (deflate(&strm, Z_FINISH) != Z_STREAM_END)
+                ok = false;
+            block->outSize = strm.total_out;
+            deflateEnd(&strm);
+        }
+        else if (compressionPolicy == intel_zipstream::BZipCompression)
+        {
+            // bzip2 output is at most 1% + 600 bytes larger than its input.
+            unsigned int destLen = block->inSize + block->inSize / 100 + 600;
+            block->out.resize(destLen);
+            if (BZ2_bzBuffToBuffCompress(&block->out[0], &destLen,
+                                         &block->in[0], block->inSize,
+                                         9, 0, 0) != BZ_OK)
+            {
+                ok = false;
+                destLen = 0;
+            }
+            block->outSize = destLen;
+        }
+        return ok;
+    }
+
+    void writeOut(BLOCK *block)
+    {
+        const char *data = &block->out[0];
+        UINT32 size = block->outSize;
+        if (compressionPolicy == intel_zipstream::NoCompression)
+        {
+            data = &block->in[0];
+            size = block->inSize;
+        }
+        if (size && fwrite(data, 1, size, filePointer) != size)
+            error = true;
+        if (writeIndex)
+        {
+            intel_block_index_entry e = { compressedOffset, size,
+                                          uncompressedOffset, block->inSize };
+            index.push_back(e);
+        }
+        compressedOffset += size;
+        uncompressedOffset += block->inSize;
+    }
+
+    // Called by a pool thread for a block this stream queued: compress a
+    // queued block and write out every block that is next in sequence.
+    void compressQueued()
+    {
+        PIN_MutexLock(&mutex);
+        BLOCK *block = findBlock(BLOCK::QUEUED);
+        if (!block)
+        {
+            PIN_MutexUnlock(&mutex);
+            return;
+        }
+        block->state = BLOCK::COMPRESSING;
+        PIN_MutexUnlock(&mutex);
+
+        bool ok = compress(block);
+
+        PIN_MutexLock(&mutex);
+        error |= !ok;
+        block->state = BLOCK::DONE;
+        while ((block = findDone(nextWrite)))
+        {
+            writeOut(block);
+            block->state = BLOCK::FREE;
+            nextWrite++;
+            PIN_SemaphoreSet(&blockWritten);
+        }
+        PIN_MutexUnlock(&mutex);
+    }
+};
+
+
+// Compression thread: take queued blocks until the pool stops and no
+// block is left.
+inline VOID intel_async_pool::Worker(VOID *arg)
+{
+    intel_async_pool *pool = static_cast<intel_async_pool *>(arg);
+
+    PIN_MutexLock(&pool->mutex);
+    while (true)
+    {
+        if (pool->work.empty())
+        {
+            if (pool->exiting)
+                break;
+            PIN_SemaphoreClear(&pool->workReady);
+            PIN_MutexUnlock(&pool->mutex);
+            PIN_SemaphoreWait(&pool->workReady);
+            PIN_MutexLock(&pool->mutex);
+            continue;
+        }
+        intel_async_ostreambuf *sb = pool->work.front();
+        pool->work.pop_front();
+        PIN_MutexUnlock(&pool->mutex);
+
+        sb->compressQueued();
+
+        PIN_MutexLock(&pool->mutex);
+    }
+    PIN_MutexUnlock(&pool->mutex);
+}
+
+
+/** Create a custom output stream for streaming into a compressed file with
+    compression done on internal threads.
+    This is achieved by constructing a custom streambuf (intel_async_ostreambuf)
+    and creating an object inheriting from ostream that uses it.
+*/
+class intel_async_ostream : public std::ostream {
+protected:
+    intel_async_ostreambuf ob;
+public:
+    intel_async_ostream(const std::string &name,
+                        intel_zipstream::CompressionPolicy policy,
+                        UINT32 numWorkers = 1) :
+        std::ostream(0), ob(name, policy, numWorkers) {
+        rdbuf(&ob);
+    }
+
+    bool constructorSuccessful(void){
+        return ob.constructionCompleted();
+    }
+
+    bool close(void){
+        return ob.close();
+    }
+};
+
+#endif
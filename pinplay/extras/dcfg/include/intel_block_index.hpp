@@ -0,0 +1,112 @@
+/*BEGIN_LEGAL
+  Intel Open Source License
+
+  Copyright (c) 2016 Intel Corporation. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.  Redistributions
+  in binary form must reproduce the above copyright notice, this list of
+  conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.  Neither the name of
+  the Intel Corporation nor the names of its contributors may be used to
+  endorse or promote products derived from this software without
+  specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+  ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  END_LEGAL */
+
+/** Sidecar index for block-compressed files written by
+    intel_async_ostreambuf.  Each block of such a file is an independent
+    gzip member or bzip2 stream, so any block can be decompressed on its
+    own once its location is known.  The index records, one line per
+    block, the compressed offset and size and the uncompressed offset and
+    size.  It is plain text so it can be inspected and concatenated by
+    scripts:
+
+        # INTEL-BLOCK-INDEX 1 <policy>
+        <compressed-offset> <compressed-size> <uncompressed-offset> <uncompressed-size>
+        ...
+*/
+
+#ifndef INTEL_BLOCK_INDEX_HPP
+#define INTEL_BLOCK_INDEX_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "intel_zipstream.hpp"
+
+#define INTEL_BLOCK_INDEX_SUFFIX ".idx"
+#define INTEL_BLOCK_INDEX_VERSION 1
+
+struct intel_block_index_entry {
+    uint64_t compressedOffset;
+    uint64_t compressedSize;
+    uint64_t uncompressedOffset;
+    uint64_t uncompressedSize;
+};
+
+typedef std::vector<intel_block_index_entry> intel_block_index;
+
+/** Write 'index' to 'name'.  Returns false if the file cannot be written. */
+inline bool intel_write_block_index(const std::string &name,
+                                    intel_zipstream::CompressionPolicy policy,
+                                    const intel_block_index &index)
+{
+    FILE *fp = fopen(name.c_str(), "w");
+    if (!fp)
+        return false;
+    fprintf(fp, "# INTEL-BLOCK-INDEX %d %d\n", INTEL_BLOCK_INDEX_VERSION, int(policy));
+    for (size_t i = 0; i < index.size(); i++)
+        fprintf(fp, "%llu %llu %llu %llu\n",
+                (unsigned long long)index[i].compressedOffset,
+                (unsigned long long)index[i].compressedSize,
+                (unsigned long long)index[i].uncompressedOffset,
+                (unsigned long long)index[i].uncompressedSize);
+    return fclose(fp) == 0;
+}
+
+/** Read an index written by intel_write_block_index().
+    Returns false if the file is missing or malformed. */
+inline bool intel_read_block_index(const std::string &name,
+                                   intel_zipstream::CompressionPolicy &policy,
+                                   intel_block_index &index)
+{
+    FILE *fp = fopen(name.c_str(), "r");
+    if (!fp)
+        return false;
+    int version = 0, pol = 0;
+    if (fscanf(fp, "# INTEL-BLOCK-INDEX %d %d", &version, &pol) != 2 ||
+        version != INTEL_BLOCK_INDEX_VERSION)
+    {
+        fclose(fp);
+        return false;
+    }
+    policy = intel_zipstream::CompressionPolicy(pol);
+    index.clear();
+    unsigned long long co, cs, uo, us;
+    while (fscanf(fp, "%llu %llu %llu %llu", &co, &cs, &uo, &us) == 4)
+    {
+        intel_block_index_entry e = { co, cs, uo, us };
+        index.push_back(e);
+    }
+    fclose(fp);
+    return true;
+}
+
+#endif
@@ -0,0 +1,292 @@
+/*BEGIN_LEGAL
+  Intel Open Source License
+
+  Copyright (c) 2016 Intel Corporation. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.  Redistributions
+  in binary form must reproduce the above copyright notice, this list of
+  conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.  Neither the name of
+  the Intel Corporation nor the names of its contributors may be used to
+  endorse or promote products derived from this software without
+  specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+  ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  END_LEGAL */
+
+/** Create a custom input stream for block-compressed files written by
+    intel_async_ostreambuf together with their block index.  Because every
+    block is independently compressed, the stream supports seeking to any
+    uncompressed position by decompressing only the block containing it,
+    and can be restricted to a range [begin, end) of the uncompressed data.
+
+    Several streams over disjoint ranges of the same file share nothing but
+    the (read-only) file, so a post-processing tool can split a large trace
+    with intel_block_split() and decompress and parse the pieces on
+    separate threads. */
+
+#ifndef INTEL_BLOCK_ISTREAM_HPP
+#define INTEL_BLOCK_ISTREAM_HPP
+
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include "zlib.h"
+#include "bzlib.h"
+#include "intel_block_index.hpp"
+
+// custom input streambuf that reads block-compressed files through their index
+class intel_block_istreambuf : public std::streambuf {
+public:
+    intel_block_istreambuf(const std::string &src,
+                           uint64_t begin = 0,
+                           uint64_t end = ~uint64_t(0))
+        : filePointer(NULL), fileName(src), compressionPolicy(intel_zipstream::NoCompression),
+          rangeBegin(begin), rangeEnd(end), curBlock(~size_t(0)),
+          constructionComplete(false)
+    {
+        if (!intel_read_block_index(fileName + INTEL_BLOCK_INDEX_SUFFIX,
+                                    compressionPolicy, index))
+            return;
+        filePointer = fopen(fileName.c_str(), "rb");
+        if (!filePointer)
+            return;
+        uint64_t total = size();
+        rangeEnd = std::min(rangeEnd, total);
+        rangeBegin = std::min(rangeBegin, rangeEnd);
+        constructionComplete = true;
+        setg(0, 0, 0);
+        seekTo(rangeBegin);
+    }
+
+    ~intel_block_istreambuf()
+    {
+        if (filePointer)
+            fclose(filePointer);
+    }
+
+    bool constructionCompleted(void) { return constructionComplete; }
+
+    // total uncompressed size of the file
+    uint64_t size() const
+    {
+        if (index.empty())
+            return 0;
+        return index.back().uncompressedOffset + index.back().uncompressedSize;
+    }
+
+    const intel_block_index &blockIndex() const { return index; }
+
+protected:
+    // decompress the next block into the get area
+    virtual int_type underflow()
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+        if (!constructionComplete || curBlock + 1 >= index.size())
+            return traits_type::eof();
+        if (!loadBlock(curBlock + 1))
+            return traits_type::eof();
+        uint64_t start = std::max(rangeBegin, index[curBlock].uncompressedOffset);
+        if (!setWindow(start))
+            return traits_type::eof();
+        return traits_type::to_int_type(*gptr());
+    }
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which = std::ios_base::in)
+    {
+        uint64_t base = rangeBegin;
+        if (dir == std::ios_base::cur)
+            base = tell();
+        else if (dir == std::ios_base::end)
+            base = rangeEnd;
+        return seekpos(pos_type(off_type(base) + off), which);
+    }
+
+    // Positions are absolute uncompressed offsets in the file.
+    virtual pos_type seekpos(pos_type pos,
+                             std::ios_base::openmode which = std::ios_base::in)
+    {
+        if (!constructionComplete || !(which & std::ios_base::in) ||
+            off_type(pos) < off_type(rangeBegin) || uint64_t(off_type(pos)) > rangeEnd)
+            return pos_type(off_type(-1));
+        if (!seekTo(uint64_t(off_type(pos))))
+            return pos_type(off_type(-1));
+        return pos;
+    }
+
+private:
+    FILE *filePointer;
+    std::string fileName;
+    intel_zipstream::CompressionPolicy compressionPolicy;
+    intel_block_index index;
+    uint64_t rangeBegin;
+    uint64_t rangeEnd;
+    size_t curBlock;            // block held in 'data', or ~0 if none
+    std::vector<char> data;     // uncompressed contents of curBlock
+    std::vector<char> raw;      // compressed contents of curBlock
+    bool constructionComplete;
+
+    static bool entryBefore(uint64_t pos, const intel_block_index_entry &e)
+    {
+        return pos < e.uncompressedOffset;
+    }
+
+    uint64_t tell() const
+    {
+        if (curBlock >= index.size())
+            return rangeBegin;
+        return index[curBlock].uncompressedOffset + (gptr() - eback());
+    }
+
+    bool seekTo(uint64_t pos)
+    {
+        setg(0, 0, 0);
+        if (pos >= rangeEnd)
+        {
+            // position at end of range: next underflow returns eof
+            curBlock = index.size();
+            return true;
+        }
+        intel_block_index::const_iterator it =
+            std::upper_bound(index.begin(), index.end(), pos, entryBefore);
+        size_t b = size_t(it - index.begin()) - 1;
+        return loadBlock(b) && setWindow(pos);
+    }
+
+    // expose [pos, min(block end, rangeEnd)) of the current block
+    bool setWindow(uint64_t pos)
+    {
+        const intel_block_index_entry &e = index[curBlock];
+        uint64_t stop = std::min(e.uncompressedOffset + e.uncompressedSize, rangeEnd);
+        if (pos >= stop)
+        {
+            curBlock = index.size();
+            return false;
+        }
+        char *base = &data[0];
+        setg(base, base + (pos - e.uncompressedOffset),
+             base + (stop - e.uncompressedOffset));
+        return true;
+    }
+
+    bool loadBlock(size_t b)
+    {
+        if (b == curBlock)
+            return true;
+        curBlock = index.size();
+        const intel_block_index_entry &e = index[b];
+        if (e.uncompressedOffset >= rangeEnd)
+            return false;
+        raw.resize(e.compressedSize ? e.compressedSize : 1);
+        data.resize(e.uncompressedSize ? e.uncompressedSize : 1);
+        if (fseeko(filePointer, off_t(e.compressedOffset), SEEK_SET) != 0 ||
+            fread(&raw[0], 1, e.compressedSize, filePointer) != e.compressedSize)
+            return false;
+        if (!decompress(e))
+            return false;
+        curBlock = b;
+        return true;
+    }
+
+    bool decompress(const intel_block_index_entry &e)
+    {
+        if (compressionPolicy == intel_zipstream::NoCompression)
+        {
+            std::copy(raw.begin(), raw.begin() + e.compressedSize, data.begin());
+            return e.compressedSize == e.uncompressedSize;
+        }
+        if (compressionPolicy == intel_zipstream::ZLibCompression)
+        {
+            z_stream strm;
+            memset(&strm, 0, sizeof(strm));
+            // windowBits 15+16 expects the gzip wrapper.
+            if (inflateInit2(&strm, 15 + 16) != Z_OK)
+                return false;
+            strm.next_in = reinterpret_cast<Bytef *>(&raw[0]);
+            strm.avail_in = e.compressedSize;
+            strm.next_out = reinterpret_cast<Bytef *>(&data[0]);
+            strm.avail_out = e.uncompressedSize;
+            int ret = inflate(&strm, Z_FINISH);
+            inflateEnd(&strm);
+            return ret == Z_STREAM_END && strm.total_out == e.uncompressedSize;
+        }
+        if (compressionPolicy == intel_zipstream::BZipCompression)
+        {
+            unsigned int destLen = e.uncompressedSize;
+            return BZ2_bzBuffToBuffDecompress(&data[0], &destLen,
+                                              &raw[0], e.compressedSize,
+                                              0, 0) == BZ_OK &&
+                destLen == e.uncompressedSize;
+        }
+        return false;
+    }
+};
+
+/** Create a custom input stream for reading a range of a block-compressed file.
+    This is achieved by constructing a custom streambuf (intel_block_istreambuf)
+    and creating an object inheriting from istream that uses it.
+*/
+class intel_block_istream : public std::istream {
+protected:
+    intel_block_istreambuf ib;
+public:
+    intel_block_istream(const std::string &name,
+                        uint64_t begin = 0,
+                        uint64_t end = ~uint64_t(0)) :
+        std::istream(0), ib(name, begin, end) {
+        rdbuf(&ib);
+    }
+
+    bool constructorSuccessful(void) {
+        return ib.constructionCompleted();
+    }
+};
+
+/** Split the uncompressed contents of a block-compressed file into at most
+    'n' contiguous ranges on block boundaries, with roughly equal sizes.
+    Each range is returned as [begin, end) in 'ranges'.
+    Returns false if the index cannot be read. */
+inline bool intel_block_split(const std::string &name, unsigned n,
+                              std::vector<std::pair<uint64_t, uint64_t> > &ranges)
+{
+    intel_zipstream::CompressionPolicy policy;
+    intel_block_index index;
+    ranges.clear();
+    if (!intel_read_block_index(name + INTEL_BLOCK_INDEX_SUFFIX, policy, index))
+        return false;
+    if (index.empty() || n == 0)
+        return true;
+    uint64_t total = index.back().uncompressedOffset + index.back().uncompressedSize;
+    uint64_t begin = 0;
+    for (size_t b = 0; b < index.size(); b++)
+    {
+        uint64_t end = index[b].uncompressedOffset + index[b].uncompressedSize;
+        uint64_t target = total * (ranges.size() + 1) / n;
+        if (end >= target || b + 1 == index.size())
+        {
+            ranges.push_back(std::make_pair(begin, end));
+            begin = end;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -37,6 +37,7 @@ END_LEGAL */
 #include "pinplay.H"
 #include "isimpoint_inst.H"
 #include "instlib.H"
+#include "overhead_stats.H"
 #include "pinplay-debugger-shell.H"
 #ifdef SLICING
 #include "SliceEngine.H"
@@ -46,6 +47,7 @@ using namespace INSTLIB;
 
 PINPLAY_ENGINE pinplay_engine;
 ISIMPOINT isimpoint;
+OVERHEAD_STATS overheadStats;
 DR_DEBUGGER_SHELL::ICUSTOM_INSTRUMENTOR *
     CreatePinPlayInstrumentor(DR_DEBUGGER_SHELL::ISHELL *);
 DR_DEBUGGER_SHELL::ISHELL *shell = NULL; 
@@ -86,6 +88,7 @@ main(int argc, char *argv[])
         return Usage(argv[0]);
     }
 
+    overheadStats.Activate();
 
     pinplay_engine.Activate(argc, argv, KnobLogger, KnobReplayer);
 
@@ -0,0 +1,121 @@
+/*BEGIN_LEGAL 
+BSD License 
+
+Copyright (c)2012 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string.h>
+
+#include "pin.H"
+#include "instlib.H"
+#include "simtrace.H"
+#include "pinplay.H"
+
+LOCALVAR SIMTRACE simtrace;
+
+using namespace INSTLIB; 
+
+#define KNOB_LOG_NAME  "log"
+#define KNOB_REPLAY_NAME "replay"
+#define KNOB_FAMILY "pintool:pinplay-driver"
+
+
+PINPLAY_ENGINE pinplay_engine;
+
+KNOB_COMMENT pinplay_driver_knob_family(KNOB_FAMILY, "PinPlay Driver Knobs");
+
+KNOB<BOOL>KnobReplayer(KNOB_MODE_WRITEONCE, KNOB_FAMILY,
+                       KNOB_REPLAY_NAME, "0", "Replay a pinball");
+KNOB<BOOL>KnobLogger(KNOB_MODE_WRITEONCE,  KNOB_FAMILY,
+                     KNOB_LOG_NAME, "0", "Create a pinball");
+
+KNOB<string>KnobTraceBaseName(KNOB_MODE_WRITEONCE,  "pintool",
+                     "trace", "", "Base name of the trace files (default: the replayed pinball, or simtrace).");
+KNOB<string>KnobCompress(KNOB_MODE_WRITEONCE,  "pintool",
+                     "compress", "gzip", "Compress the per-thread traces (none, gzip, bzip2).");
+KNOB<UINT32>KnobCompressThreads(KNOB_MODE_WRITEONCE,  "pintool",
+                     "compress_threads", "1", "Number of internal threads compressing the traces of all threads.");
+KNOB<UINT32>KnobBlockKB(KNOB_MODE_WRITEONCE,  "pintool",
+                     "block_kb", "1024", "Size in KB of the independently compressed blocks of a trace.");
+KNOB<BOOL>KnobIndex(KNOB_MODE_WRITEONCE,  "pintool",
+                     "index", "0", "Write a block index (<trace>.idx) next to each compressed trace.");
+
+
+INT32 Usage()
+{
+    cerr <<
+        "This pin tool is a PinPlay-enabled simulator trace exporter \n"
+        "\n";
+
+    cerr << KNOB_BASE::StringKnobSummary() << endl;
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if( PIN_Init(argc,argv) )
+    {
+        return Usage();
+    }
+
+    intel_zipstream::CompressionPolicy compression;
+    if (KnobCompress.Value() == "none")
+        compression = intel_zipstream::NoCompression;
+    else if (KnobCompress.Value() == "gzip")
+        compression = intel_zipstream::GZipCompression;
+    else if (KnobCompress.Value() == "bzip2")
+        compression = intel_zipstream::BZipCompression;
+    else
+        return Usage();
+    if (KnobBlockKB.Value() == 0)
+        return Usage();
+
+    pinplay_engine.Activate(argc, argv, KnobLogger, KnobReplayer);
+    if(KnobLogger)
+    {
+        cout << "Logger basename " << pinplay_engine.LoggerGetBaseName() 
+            << endl;
+    }
+    if(KnobReplayer)
+    {
+        cout << "Replayer basename " << pinplay_engine.ReplayerGetBaseName() 
+            << endl;
+    }
+
+    // one trace per region pinball, next to it by default
+    string base = KnobTraceBaseName.Value();
+    if (base.empty())
+        base = KnobReplayer ? pinplay_engine.ReplayerGetBaseName() : "simtrace";
+    simtrace.Activate(base, compression, KnobCompressThreads,
+                      KnobBlockKB.Value() * 1024, KnobIndex);
+
+    PIN_StartProgram();
+}
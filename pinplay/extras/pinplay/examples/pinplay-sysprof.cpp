@@ -0,0 +1,101 @@
+/*BEGIN_LEGAL 
+BSD License 
+
+Copyright (c)2012 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string.h>
+
+#include "pin.H"
+#include "instlib.H"
+#include "sysprof.H"
+#include "pinplay.H"
+
+LOCALVAR SYSPROF sysprof;
+
+using namespace INSTLIB; 
+
+LOCALVAR ofstream *outfile;
+
+#define KNOB_LOG_NAME  "log"
+#define KNOB_REPLAY_NAME "replay"
+#define KNOB_FAMILY "pintool:pinplay-driver"
+
+
+PINPLAY_ENGINE pinplay_engine;
+
+KNOB_COMMENT pinplay_driver_knob_family(KNOB_FAMILY, "PinPlay Driver Knobs");
+
+KNOB<BOOL>KnobReplayer(KNOB_MODE_WRITEONCE, KNOB_FAMILY,
+                       KNOB_REPLAY_NAME, "0", "Replay a pinball");
+KNOB<BOOL>KnobLogger(KNOB_MODE_WRITEONCE,  KNOB_FAMILY,
+                     KNOB_LOG_NAME, "0", "Create a pinball");
+
+KNOB<string>KnobProfileFileName(KNOB_MODE_WRITEONCE,  "pintool",
+                     "profile", "sysprof.out", "Name of the profile file.");
+KNOB<string>KnobEventBaseName(KNOB_MODE_WRITEONCE,  "pintool",
+                     "events", "", "Write a binary log of every system call to <events>.<tid>.sysevents.");
+
+
+INT32 Usage()
+{
+    cerr <<
+        "This pin tool is a PinPlay-enabled system call profiler \n"
+        "\n";
+
+    cerr << KNOB_BASE::StringKnobSummary() << endl;
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if( PIN_Init(argc,argv) )
+    {
+        return Usage();
+    }
+
+    outfile = new ofstream(KnobProfileFileName.Value().c_str());
+    sysprof.Activate(outfile, KnobEventBaseName);
+    
+    pinplay_engine.Activate(argc, argv, KnobLogger, KnobReplayer);
+    if(KnobLogger)
+    {
+        cout << "Logger basename " << pinplay_engine.LoggerGetBaseName() 
+            << endl;
+    }
+    if(KnobReplayer)
+    {
+        cout << "Replayer basename " << pinplay_engine.ReplayerGetBaseName() 
+            << endl;
+    }
+
+    PIN_StartProgram();
+}
@@ -0,0 +1,153 @@
+/*BEGIN_LEGAL
+BSD License
+
+Copyright (c)2016 Intel Corporation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+
+// Reads a gzip compressed, block indexed file (pinplay-simtrace -index)
+// through intel_block_istream and checks it against a plain zlib
+// decompression of the whole file: a sequential read, seeks to every
+// block boundary and to positions inside blocks, and the ranges of
+// intel_block_split() read one after the other.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "intel_block_istream.hpp"
+
+using namespace std;
+
+static bool ReadAll(const char *name, vector<char> &data)
+{
+    gzFile gz = gzopen(name, "rb");
+    if (!gz)
+        return false;
+    char buf[65536];
+    int n;
+    while ((n = gzread(gz, buf, sizeof(buf))) > 0)
+        data.insert(data.end(), buf, buf + n);
+    gzclose(gz);
+    return n == 0;
+}
+
+// Read [begin, end) from 'in' and compare it with the reference; with
+// 'atEnd' the stream must end there.
+static bool Check(istream &in, const vector<char> &ref,
+                  uint64_t begin, uint64_t end, bool atEnd, const char *what)
+{
+    vector<char> got(end - begin + 1);
+    in.read(&got[0], end - begin);
+    if (uint64_t(in.gcount()) != end - begin ||
+        memcmp(&got[0], &ref[0] + begin, end - begin) != 0 ||
+        (atEnd && in.peek() != EOF))
+    {
+        fprintf(stderr, "blockcheck: %s [%llu, %llu) differs\n", what,
+                (unsigned long long)begin, (unsigned long long)end);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: blockcheck <file.gz>\n");
+        return 1;
+    }
+    const char *name = argv[1];
+
+    vector<char> ref;
+    if (!ReadAll(name, ref))
+    {
+        fprintf(stderr, "blockcheck: cannot decompress %s\n", name);
+        return 1;
+    }
+
+    intel_block_istream whole(name);
+    if (!whole.constructorSuccessful())
+    {
+        fprintf(stderr, "blockcheck: cannot open %s with its index\n", name);
+        return 1;
+    }
+    if (!Check(whole, ref, 0, ref.size(), true, "sequential read"))
+        return 1;
+
+    intel_zipstream::CompressionPolicy policy;
+    intel_block_index index;
+    intel_read_block_index(string(name) + INTEL_BLOCK_INDEX_SUFFIX, policy, index);
+
+    // block boundaries, the bytes around them, and the middle of blocks
+    vector<uint64_t> positions;
+    for (size_t b = 0; b < index.size(); b++)
+    {
+        uint64_t start = index[b].uncompressedOffset;
+        positions.push_back(start);
+        positions.push_back(start + index[b].uncompressedSize / 2);
+        if (start > 0)
+            positions.push_back(start - 1);
+    }
+    intel_block_istream seeker(name);
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        uint64_t pos = positions[i];
+        uint64_t end = pos + 4096 < ref.size() ? pos + 4096 : ref.size();
+        seeker.clear();
+        seeker.seekg(pos);
+        if (!seeker || !Check(seeker, ref, pos, end, false, "seek"))
+            return 1;
+    }
+
+    vector<pair<uint64_t, uint64_t> > ranges;
+    intel_block_split(name, 4, ranges);
+    uint64_t next = 0;
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        if (ranges[r].first != next)
+        {
+            fprintf(stderr, "blockcheck: split range %u does not start at %llu\n",
+                    unsigned(r), (unsigned long long)next);
+            return 1;
+        }
+        intel_block_istream part(name, ranges[r].first, ranges[r].second);
+        if (!Check(part, ref, ranges[r].first, ranges[r].second, true,
+                   "split range"))
+            return 1;
+        next = ranges[r].second;
+    }
+    if (next != ref.size())
+    {
+        fprintf(stderr, "blockcheck: split ranges end at %llu, not %llu\n",
+                (unsigned long long)next, (unsigned long long)ref.size());
+        return 1;
+    }
+
+    printf("blockcheck: %s OK, %u blocks, %llu bytes\n", name,
+           unsigned(index.size()), (unsigned long long)ref.size());
+    return 0;
+}
@@ -681,6 +681,18 @@ def prolog_length(parser, group):
            "Default: 0")
 
 
+def region_batches(parser, group):
+    method = GetMethod(parser, group)
+    method("--region_batches",
+           dest="region_batches",
+           action="store_true",
+           default=False,
+           help="Split the regions of each whole program pinball into batches "
+           "without overlap and relog all the batches concurrently in the first "
+           "pass, instead of one pass per set of overlapping regions. "
+           "Default: relog overlapping regions in successive passes.")
+
+
 def warmup_length(parser, group):
     """Note: Default values are NOT set here. They are set in the high level scripts."""
 
@@ -1082,6 +1082,12 @@ class Phases(object):
             #
             return 0
 
+        # Regions skipped by any batch of the first pass are relogged in the
+        # next pass.
+        #
+        if self.MergeBatchOutputs(in_file, out_file) != 0:
+            return -1
+
         if os.path.isfile(out_file) and os.path.getsize(out_file) > 0:
 
             # Double check to see if there are clusters in the old output file.
@@ -1123,6 +1129,143 @@ class Phases(object):
                     return -1
         return 0
 
+    def BatchCSVFiles(self, in_file, out_file, batch):
+        """
+        Get the input and output CSV files of one batch of regions.
+
+        Batch 1 uses the original files.  The names keep the '.in.csv' and
+        '.out.csv' suffixes used to recognize region CSV files.
+
+        @return list containing: input and output file name
+        """
+
+        if batch == 1:
+            return [in_file, out_file]
+        suffix = '.b' + str(batch)
+        return [in_file.replace('.in.csv', suffix + '.in.csv'),
+                out_file.replace('.out.csv', suffix + '.out.csv')]
+
+    def RegionSpan(self, start, end):
+        """
+        Get the instructions covered by a region, including its warmup, prolog
+        and epilog, the same way as the regions controller computes them.
+
+        @return list containing: first and last icount of the span
+        """
+
+        begin = start
+        if config.prolog_length and start - config.prolog_length > 0:
+            begin = start - config.prolog_length
+        if config.warmup_length and \
+           start - config.prolog_length - config.warmup_length > 0:
+            begin = start - config.prolog_length - config.warmup_length
+        return [begin, end + config.epilog_length]
+
+    def PartitionRegions(self, in_file, out_file):
+        """
+        Split the regions in a CSV file into batches without overlap.
+
+        The regions controller skips any region which overlaps a region
+        already accepted for the same thread, which is why region pinball
+        generation needs one relogging pass per set of overlapping regions.
+        Batches are built with a first fit on the regions sorted by the start
+        of their span, which uses the minimum number of batches.  Each batch
+        is written to its own CSV file so all the batches can be relogged
+        concurrently.  Comment lines before a region stay with the region,
+        the header and the lines after the last region are copied to every
+        batch.
+
+        @return list of input CSV files, one per batch
+        """
+
+        try:
+            f = open(in_file)
+        except IOError:
+            msg.PrintMsg('\nERROR: Unable to open file:\n    ' + in_file)
+            return []
+        lines = f.readlines()
+        f.close()
+
+        header = []
+        regions = []
+        pending = []
+        for line in lines:
+            fields = line.partition('#')[0].strip().split(',')
+            if len(fields) >= 6 and fields[0].lower() != 'comment' and \
+               util.IsInt(fields[1]) and util.IsInt(fields[3]) and \
+               util.IsInt(fields[4]):
+                [begin, end] = self.RegionSpan(int(fields[3]), int(fields[4]))
+                regions.append((begin, end, int(fields[1]), pending + [line]))
+                pending = []
+            elif fields[0].lower() == 'comment':
+                header += pending + [line]
+                pending = []
+            else:
+                pending.append(line)
+        trailer = pending
+
+        # Each batch keeps the end of the last span of each thread.
+        #
+        regions.sort(key=lambda r: r[0])
+        batches = []
+        for (begin, end, tid, text) in regions:
+            for batch in batches:
+                if batch['end'].get(tid, -1) < begin:
+                    break
+            else:
+                batch = {'end': {}, 'lines': []}
+                batches.append(batch)
+            batch['end'][tid] = end
+            batch['lines'] += text
+
+        in_files = []
+        for i in range(len(batches)):
+            [batch_in, batch_out] = self.BatchCSVFiles(in_file, out_file, i + 1)
+            try:
+                f = open(batch_in, 'w')
+                f.writelines(header + batches[i]['lines'] + trailer)
+                f.close()
+            except IOError:
+                msg.PrintMsg('\nERROR: Unable to write file:\n    ' + batch_in)
+                return []
+            in_files.append(batch_in)
+        return in_files
+
+    def MergeBatchOutputs(self, in_file, out_file):
+        """
+        Append the regions skipped in the batches of the first pass to the
+        output CSV file of the pinball, so they are relogged in the next pass.
+        The input CSV files of the batches are no longer needed and are
+        removed.
+
+        @return error_code
+        """
+
+        try:
+            for batch_file in glob.glob(in_file.replace('.in.csv', '.b*.in.csv')):
+                os.remove(batch_file)
+        except OSError:
+            msg.PrintMsg('\nERROR: Unable to remove batch input files of:\n    ' +
+                         in_file)
+            return -1
+
+        batch_files = glob.glob(out_file.replace('.out.csv', '.b*.out.csv'))
+        if not batch_files:
+            return 0
+        try:
+            f = open(out_file, 'a')
+            for batch_file in sorted(batch_files):
+                b = open(batch_file)
+                f.writelines(l for l in b.readlines() if not l.startswith('#eof'))
+                b.close()
+                os.remove(batch_file)
+            f.close()
+        except (IOError, OSError):
+            msg.PrintMsg('\nERROR: Unable to merge batch output files into:\n    ' +
+                         out_file)
+            return -1
+        return 0
+
     def GenRegionPinballs(self, replayer_cmd, file_name, options, count):
         """
         Generate a set of region pinballs for one whole program pinball.
@@ -1152,6 +1295,37 @@ class Phases(object):
         if not os.path.isdir(pp_dir):
             os.mkdir(pp_dir)
 
+        # With region batches, all the regions are relogged in the first pass,
+        # one concurrent relogging job per batch.
+        #
+        batches = [[in_file, out_file]]
+        if count == 1 and hasattr(options, 'region_batches') and \
+           options.region_batches and not (hasattr(options, 'list') and options.list):
+            batch_files = self.PartitionRegions(in_file, out_file)
+            if not batch_files:
+                return -1
+            batches = [self.BatchCSVFiles(in_file, out_file, i + 1)
+                       for i in range(len(batch_files))]
+            msg.PrintMsgPlus('Relogging %d batch(es) of regions for: %s' %
+                             (len(batches), basename))
+
+        result = 0
+        for [in_file, out_file] in batches:
+            result = self.RelogRegions(replayer_cmd, file_name, options, count,
+                                       basename, pp_file, in_file, out_file)
+            if result != 0:
+                break
+        return result
+
+    def RelogRegions(self, replayer_cmd, file_name, options, count, basename,
+                     pp_file, in_file, out_file):
+        """
+        Relog one whole program pinball to generate the region pinballs for
+        the regions in one input CSV file.
+
+        @return error_code
+        """
+
         # Format the command to relog.
         #
         cmd = replayer_cmd + ' --replay_file ' + file_name
@@ -331,6 +331,7 @@ class PinPoints(object):
 
         cmd_options.epilog_length(parser, region_pb_phase_group)
         cmd_options.prolog_length(parser, region_pb_phase_group)
+        cmd_options.region_batches(parser, region_pb_phase_group)
         cmd_options.warmup_length(parser, region_pb_phase_group)
 
         parser.add_option_group(region_pb_phase_group)
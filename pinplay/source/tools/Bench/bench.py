@@ -0,0 +1,178 @@
+#!/usr/bin/env python
+#
+# Runs the tool overhead benchmarks: every workload is run natively and
+# under every benchmarked tool, and each run becomes one CSV row with its
+# wall time, its slowdown over the median native run, and the statistics
+# the tool wrote with -overhead_stats (see InstLib/overhead_stats.H).
+#
+# Usually run through "make bench" in this directory.
+
+import optparse
+import os
+import shlex
+import subprocess
+import sys
+import time
+
+
+# (name, directory under the tools root, application)
+WORKLOADS = [
+    ("threadApp", "Tests", "threadApp"),
+    ("thread2", "MemTrace", "thread2"),
+    ("test-mt", "Mix", "test-mt"),
+]
+
+# (name, tool path, tool arguments); {root}, {objdir}, {pinplay} and {so}
+# are filled in from the command line.  Output files land in the work
+# directory.
+TOOLS = [
+    ("icount", "{root}/SimpleExamples/{objdir}icount{so}", []),
+    ("mix-mt", "{root}/Mix/{objdir}mix-mt{so}", ["-o", "mix-mt.out"]),
+    ("isimpoint", "{pinplay}/pinplay-driver{so}",
+        ["-bbprofile", "-slice_size", "1000000", "-o", "isimpoint"]),
+    ("isimpoint-ldv", "{pinplay}/pinplay-driver{so}",
+        ["-bbprofile", "-slice_size", "1000000", "-o", "isimpoint-ldv",
+         "-ldv_type", "approx"]),
+    ("allcache", "{root}/Memory/{objdir}allcache{so}", []),
+    ("membuffer", "{root}/MemTrace/{objdir}membuffer{so}", ["-o", "membuffer.out"]),
+    ("membuffer_simple", "{root}/MemTrace/{objdir}membuffer_simple{so}", []),
+]
+
+# The -overhead_stats lines, in CSV column order
+STATS = [
+    "wall_usec",
+    "instrument_usec",
+    "traces",
+    "instructions",
+    "cache_flushes",
+    "cache_used_bytes",
+    "cache_reserved_bytes",
+    "cache_directory_bytes",
+    "cache_traces",
+    "cache_exit_stubs",
+]
+
+STATS_FILE = "overhead_stats.out"
+
+
+def Run(cmd, workDir):
+    """
+    Run a command in the work directory.
+
+    @return:    (exit status, wall time in seconds)
+    """
+    devnull = open(os.devnull, "w")
+    start = time.time()
+    status = subprocess.call(cmd, cwd=workDir, stdout=devnull, stderr=devnull)
+    wall = time.time() - start
+    devnull.close()
+    return (status, wall)
+
+
+def ReadStats(path):
+    """
+    Read an -overhead_stats file.
+
+    @return:    Dictionary of statistic name to value string.
+    """
+    stats = {}
+    if not os.path.exists(path):
+        return stats
+    for line in open(path).readlines():
+        fields = line.split()
+        if len(fields) == 2:
+            stats[fields[0]] = fields[1]
+    return stats
+
+
+def Median(values):
+    values = sorted(values)
+    if not values:
+        return 0.0
+    return values[len(values) // 2]
+
+
+def Main(argv):
+    parser = optparse.OptionParser()
+    parser.add_option("--pin", dest="pin", type="string", default="",
+        help="Pin command line, up to the tool.  Required.")
+    parser.add_option("--tools-root", dest="root", type="string", default="..",
+        help="The source/tools directory.")
+    parser.add_option("--objdir", dest="objdir", type="string", default="obj-intel64/",
+        help="Object directory of the tools and workloads, with the trailing '/'.")
+    parser.add_option("--pinplay-bin", dest="pinplay", type="string", default="",
+        help="Directory holding pinplay-driver, for the isimpoint runs.")
+    parser.add_option("--tool-suffix", dest="so", type="string", default=".so",
+        help="Suffix of the tools.")
+    parser.add_option("--exe-suffix", dest="exe", type="string", default="",
+        help="Suffix of the workloads.")
+    parser.add_option("--repeat", dest="repeat", type="int", default=3,
+        help="Number of runs of every configuration.")
+    parser.add_option("--only", dest="only", type="string", default="",
+        help="Comma separated tools to run (default: all).")
+    parser.add_option("--work-dir", dest="workDir", type="string", default=".",
+        help="Directory the runs execute in.")
+    parser.add_option("--out", dest="out", type="string", default="bench.csv",
+        help="CSV results file.")
+
+    (options, args) = parser.parse_args(args=argv)
+    if not options.pin:
+        sys.stderr.write("bench.py: --pin is required\n")
+        return 1
+
+    pin = shlex.split(options.pin)
+    root = os.path.abspath(options.root)
+    workDir = os.path.abspath(options.workDir)
+    if not os.path.isdir(workDir):
+        os.makedirs(workDir)
+    only = [t for t in options.only.split(",") if t]
+
+    out = open(options.out, "w")
+    out.write(",".join(["workload", "tool", "run", "status", "wall_sec", "slowdown"] + STATS) + "\n")
+
+    failed = 0
+    for (workload, directory, app) in WORKLOADS:
+        appPath = os.path.join(root, directory, options.objdir + app + options.exe)
+        if not os.path.exists(appPath):
+            sys.stderr.write("bench.py: skipping %s, %s is not built\n" % (workload, appPath))
+            continue
+
+        native = []
+        for run in range(options.repeat):
+            (status, wall) = Run([appPath], workDir)
+            native.append(wall)
+            failed += (status != 0)
+            out.write("%s,native,%d,%d,%.6f,1.0%s\n" % (workload, run, status, wall, "," * len(STATS)))
+        baseline = Median(native)
+
+        for (tool, pathFormat, toolArgs) in TOOLS:
+            if only and tool not in only:
+                continue
+            toolPath = pathFormat.format(root=root, objdir=options.objdir,
+                                         pinplay=options.pinplay, so=options.so)
+            if not os.path.exists(toolPath):
+                sys.stderr.write("bench.py: skipping %s, %s is not built\n" % (tool, toolPath))
+                continue
+
+            statsPath = os.path.join(workDir, STATS_FILE)
+            for run in range(options.repeat):
+                if os.path.exists(statsPath):
+                    os.remove(statsPath)
+                cmd = pin + ["-t", toolPath, "-overhead_stats", STATS_FILE] + toolArgs + ["--", appPath]
+                (status, wall) = Run(cmd, workDir)
+                failed += (status != 0)
+                stats = ReadStats(statsPath)
+                slowdown = wall / baseline if baseline > 0 else 0.0
+                out.write("%s,%s,%d,%d,%.6f,%.3f,%s\n" % (workload, tool, run, status, wall, slowdown,
+                                                          ",".join([stats.get(s, "") for s in STATS])))
+                out.flush()
+    out.close()
+
+    if failed:
+        sys.stderr.write("bench.py: %d runs failed, see the status column of %s\n" % (failed, options.out))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(Main(sys.argv[1:]))
@@ -0,0 +1,114 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+//
+//  This tool manages the code cache with CODECACHE_MANAGER: it writes a
+//    time series of the code cache usage and, when the cache is full,
+//    keeps hot traces by growing the cache or flushes mostly cold code.
+//  Sample usage:
+//    pin -cc_memory_size 393216 -t cache_manager -o cache_manager.out -- /bin/ls
+
+#include "pin.H"
+#include "portability.H"
+#include "utils.H"
+#include "codecache_manager.H"
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+/* ================================================================== */
+/* Global Data Structures                                             */
+/* ================================================================== */
+
+CODECACHE_MANAGER manager;
+ofstream SeriesFile;
+
+/* ================================================================== */
+/* Command-Line Switches                                              */
+/* ================================================================== */
+KNOB<BOOL>  KnobHelp(KNOB_MODE_WRITEONCE, "pintool",
+    "hh", "0", "Print help message (command-line switches)");
+KNOB<string> KnobOutputFile(KNOB_MODE_WRITEONCE, "pintool",
+    "o", "cache_manager.out", "specify time series file name");
+KNOB<BOOL>   KnobPid(KNOB_MODE_WRITEONCE, "pintool",
+    "p", "0", "append pid to output");
+KNOB<UINT32> KnobSamplePeriod(KNOB_MODE_WRITEONCE, "pintool",
+    "sample", "1000", "trace insertions between samples");
+KNOB<UINT64> KnobHotThreshold(KNOB_MODE_WRITEONCE, "pintool",
+    "hot", "64", "aged executions for a trace to count as hot");
+KNOB<UINT32> KnobKeepPercent(KNOB_MODE_WRITEONCE, "pintool",
+    "keep", "50", "grow instead of flushing if hot traces use this % of the cache");
+KNOB<UINT32> KnobMaxLimit(KNOB_MODE_WRITEONCE, "pintool",
+    "max_limit", "0", "never grow the cache beyond this many bytes (0: no bound)");
+
+/* ================================================================== */
+/*
+ Print the summary at the end of the run
+*/
+VOID PrintSummary(INT32 code, VOID *v)
+{
+    manager.Sample("exit");
+    SeriesFile << "#" << endl;
+    manager.PrintSummary(SeriesFile);
+    SeriesFile << "#eof" << endl;
+    SeriesFile.close();
+}
+
+/* ================================================================== */
+/*
+ Initialize and begin program execution under the control of Pin
+*/
+int main(INT32 argc, CHAR **argv)
+{
+    if (PIN_Init(argc, argv) || KnobHelp) return Usage();
+
+    string logFileName = KnobOutputFile.Value();
+    if( KnobPid )
+        logFileName += "." + decstr( getpid_portable() );
+    SeriesFile.open(logFileName.c_str());
+
+    CODECACHE_MANAGER::CONFIG config;
+    config.samplePeriod = KnobSamplePeriod;
+    config.hotThreshold = KnobHotThreshold;
+    config.keepPercent = KnobKeepPercent;
+    config.maxCacheLimit = KnobMaxLimit;
+    manager.Activate(config, &SeriesFile);
+
+    // Register a routine that gets called when the cache is first initialized
+    CODECACHE_AddCacheInitFunction(PrintInitInfo, 0);
+
+    // Register a routine that gets called when the program ends
+    PIN_AddFiniFunction(PrintSummary, 0);
+    
+    PIN_StartProgram();  // Never returns
+    
+    return 0;
+}
@@ -38,6 +38,8 @@ END_LEGAL */
 /*! @file
  *  This file contains a tool that generates instructions traces with values.
  *  It is designed to help debugging.
+ *  With -binary every thread writes compact records to a file of its own,
+ *  debugtrace_decode turns them back into the text.
  */
 
 
@@ -46,7 +48,9 @@ END_LEGAL */
 #include "instlib.H"
 #include "control_manager.H"
 #include "portability.H"
+#include "debugtrace_binary.h"
 #include <vector>
+#include <map>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -79,6 +83,9 @@ KNOB<BOOL>   KnobTraceMemory(KNOB_MODE_WRITEONCE,       "pintool",
 KNOB<BOOL>   KnobSilent(KNOB_MODE_WRITEONCE,       "pintool",
     "silent", "0", "Do everything but write file (for debugging).");
 KNOB<BOOL> KnobEarlyOut(KNOB_MODE_WRITEONCE, "pintool", "early_out", "0" , "Exit after tracing the first region.");
+KNOB<BOOL>   KnobBinary(KNOB_MODE_WRITEONCE,       "pintool",
+    "binary", "0", "Write a binary trace per thread (<o>.<tid>.bin, <o>.strings), "
+    "see debugtrace_decode.");
 
 
 /* ===================================================================== */
@@ -123,6 +130,119 @@ LOCALFUN VOID Flush()
         out << flush;
 }
 
+/* ===================================================================== */
+/* Binary trace */
+/* ===================================================================== */
+
+/*
+  Analysis routines append records to a buffer of their own thread, which
+  is written to the thread's file when full. The text of the records is
+  kept once, in a string table, see debugtrace_binary.h.
+*/
+
+LOCALVAR string binaryBase;
+
+LOCALVAR PIN_LOCK stringsLock;
+LOCALVAR vector<vector<string> > strings;
+LOCALVAR map<ADDRINT, UINT32> targetStrings;
+
+LOCALFUN UINT32 AddString(const string & s)
+{
+    PIN_GetLock(&stringsLock, 1);
+    UINT32 id = strings.size();
+    strings.push_back(vector<string>(1, s));
+    PIN_ReleaseLock(&stringsLock);
+    return id;
+}
+
+LOCALFUN UINT32 AddInstructionString(const string & s, UINT32 regCount, REG regs[])
+{
+    PIN_GetLock(&stringsLock, 1);
+    UINT32 id = strings.size();
+    strings.push_back(vector<string>(1, s));
+    for (UINT32 i = 0; i < regCount; i++)
+        strings.back().push_back(REG_StringShort(regs[i]));
+    PIN_ReleaseLock(&stringsLock);
+    return id;
+}
+
+LOCALFUN VOID WriteStrings()
+{
+    string filename = binaryBase + ".strings";
+    std::ofstream file(filename.c_str());
+    for (UINT32 id = 0; id < strings.size(); id++)
+    {
+        file << id << " " << strings[id].size() << "\n";
+        for (UINT32 i = 0; i < strings[id].size(); i++)
+            file << strings[id][i] << "\n";
+    }
+    file.close();
+}
+
+const UINT32 BinaryBufferWords = 1 << 16;
+
+struct THREAD_BUFFER
+{
+    std::ofstream * file;
+    UINT64 * words;
+    UINT32 used;
+};
+
+LOCALVAR THREAD_BUFFER buffers[PIN_MAX_THREADS];
+
+LOCALFUN VOID BinaryFlush(THREADID threadid)
+{
+    THREAD_BUFFER * b = &buffers[threadid];
+    if (b->used)
+    {
+        b->file->write(reinterpret_cast<const char *>(b->words), b->used * sizeof(UINT64));
+        b->used = 0;
+    }
+}
+
+// Room for a record of n words in the thread's buffer
+LOCALFUN UINT64 * BinaryRecord(THREADID threadid, UINT32 n)
+{
+    ASSERTX(n <= BinaryBufferWords);
+    THREAD_BUFFER * b = &buffers[threadid];
+    if (!b->file)
+    {
+        // A reused thread id continues the same file
+        string filename = binaryBase + "." + decstr(threadid) + ".bin";
+        b->file = new std::ofstream(filename.c_str(), ios::out | ios::binary);
+        b->words = new UINT64[BinaryBufferWords];
+        b->file->write(DT_MAGIC, DT_MAGIC_SIZE);
+        UINT64 tid = threadid;
+        b->file->write(reinterpret_cast<const char *>(&tid), sizeof(tid));
+    }
+    if (b->used + n > BinaryBufferWords)
+        BinaryFlush(threadid);
+    UINT64 * record = b->words + b->used;
+    b->used += n;
+    return record;
+}
+
+LOCALFUN VOID BinaryDone(THREADID threadid)
+{
+    if (KnobFlush)
+    {
+        BinaryFlush(threadid);
+        buffers[threadid].file->flush();
+    }
+}
+
+LOCALFUN VOID BinaryClose()
+{
+    for (THREADID i = 0; i < PIN_MAX_THREADS; i++)
+    {
+        if (!buffers[i].file)
+            continue;
+        BinaryFlush(i);
+        buffers[i].file->close();
+    }
+    WriteStrings();
+}
+
 /* ===================================================================== */
 
 LOCALFUN VOID Fini(int, VOID * v);
@@ -235,6 +355,66 @@ VOID Emit4Values(THREADID threadid, string * str, string * reg1str, ADDRINT reg1
 }
 
 
+VOID BinaryEmitNoValues(THREADID threadid, UINT32 id)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 1);
+    r[0] = DT_Header(DT_INS, 0, id);
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmit1Values(THREADID threadid, UINT32 id, ADDRINT reg1val)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 2);
+    r[0] = DT_Header(DT_INS, 1, id);
+    r[1] = reg1val;
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmit2Values(THREADID threadid, UINT32 id, ADDRINT reg1val, ADDRINT reg2val)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 3);
+    r[0] = DT_Header(DT_INS, 2, id);
+    r[1] = reg1val;
+    r[2] = reg2val;
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmit3Values(THREADID threadid, UINT32 id, ADDRINT reg1val, ADDRINT reg2val, ADDRINT reg3val)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 4);
+    r[0] = DT_Header(DT_INS, 3, id);
+    r[1] = reg1val;
+    r[2] = reg2val;
+    r[3] = reg3val;
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmit4Values(THREADID threadid, UINT32 id, ADDRINT reg1val, ADDRINT reg2val, ADDRINT reg3val, ADDRINT reg4val)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 5);
+    r[0] = DT_Header(DT_INS, 4, id);
+    r[1] = reg1val;
+    r[2] = reg2val;
+    r[3] = reg3val;
+    r[4] = reg4val;
+    BinaryDone(threadid);
+}
+
 const UINT32 MaxEmitArgs = 4;
 
 AFUNPTR emitFuns[] = 
@@ -242,6 +422,11 @@ AFUNPTR emitFuns[] =
     AFUNPTR(EmitNoValues), AFUNPTR(Emit1Values), AFUNPTR(Emit2Values), AFUNPTR(Emit3Values), AFUNPTR(Emit4Values)
 };
 
+AFUNPTR binaryEmitFuns[] = 
+{
+    AFUNPTR(BinaryEmitNoValues), AFUNPTR(BinaryEmit1Values), AFUNPTR(BinaryEmit2Values), AFUNPTR(BinaryEmit3Values), AFUNPTR(BinaryEmit4Values)
+};
+
 /* ===================================================================== */
 
 VOID EmitXMM(THREADID threadid, UINT32 regno, PIN_REGISTER* xmm)
@@ -260,9 +445,20 @@ VOID EmitXMM(THREADID threadid, UINT32 regno, PIN_REGISTER* xmm)
     Flush();
 }
 
+VOID BinaryEmitXMM(THREADID threadid, UINT32 regno, PIN_REGISTER* xmm)
+{
+    if (!Emit(threadid))
+        return;
+    UINT64 * r = BinaryRecord(threadid, 3);
+    r[0] = DT_Header(DT_XMM, regno, 0);
+    r[1] = xmm->qword[0];
+    r[2] = xmm->qword[1];
+    BinaryDone(threadid);
+}
+
 VOID AddXMMEmit(INS ins, IPOINT point, REG xmm_dst) 
 {
-    INS_InsertCall(ins, point, AFUNPTR(EmitXMM), IARG_THREAD_ID,
+    INS_InsertCall(ins, point, KnobBinary ? AFUNPTR(BinaryEmitXMM) : AFUNPTR(EmitXMM), IARG_THREAD_ID,
                    IARG_UINT32, xmm_dst - REG_XMM0,
                    IARG_REG_CONST_REFERENCE, xmm_dst,
                    IARG_END);
@@ -273,6 +469,22 @@ VOID AddEmit(INS ins, IPOINT point, string & traceString, UINT32 regCount, REG r
     if (regCount > MaxEmitArgs)
         regCount = MaxEmitArgs;
     
+    if (KnobBinary)
+    {
+        IARGLIST values = IARGLIST_Alloc();
+        for (UINT32 i = 0; i < regCount; i++)
+        {
+            IARGLIST_AddArguments(values, IARG_REG_VALUE, regs[i], IARG_END);
+        }
+
+        INS_InsertCall(ins, point, binaryEmitFuns[regCount], IARG_THREAD_ID,
+                       IARG_UINT32, AddInstructionString(traceString, regCount, regs),
+                       IARG_IARGLIST, values,
+                       IARG_END);
+        IARGLIST_Free(values);
+        return;
+    }
+
     IARGLIST args = IARGLIST_Alloc();
     for (UINT32 i = 0; i < regCount; i++)
     {
@@ -377,6 +589,35 @@ VOID EmitWrite(THREADID threadid, UINT32 size)
     Flush();
 }
 
+// Record a memory access with its data
+VOID BinaryEmitMemory(THREADID threadid, UINT32 kind, VOID * ea, UINT32 size)
+{
+    UINT32 n = DT_DataWords(size);
+    UINT64 * r = BinaryRecord(threadid, 2 + n);
+    r[0] = DT_Header(kind, size, 0);
+    r[1] = reinterpret_cast<ADDRINT>(ea);
+    if (n)
+    {
+        r[1 + n] = 0;
+        PIN_SafeCopy(r + 2, ea, size);
+    }
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmitWrite(THREADID threadid, UINT32 size)
+{
+    if (!Emit(threadid))
+        return;
+    BinaryEmitMemory(threadid, DT_WRITE, WriteEa[threadid], size);
+}
+
+VOID BinaryEmitRead(THREADID threadid, VOID * ea, UINT32 size)
+{
+    if (!Emit(threadid))
+        return;
+    BinaryEmitMemory(threadid, DT_READ, ea, size);
+}
+
 VOID EmitRead(THREADID threadid, VOID * ea, UINT32 size)
 {
     if (!Emit(threadid))
@@ -526,6 +767,62 @@ VOID EmitIndirectCall(THREADID threadid, string * str, ADDRINT target, ADDRINT a
     Flush();
 }
 
+VOID BinaryEmitDirectCall(THREADID threadid, UINT32 id, INT32 tailCall, ADDRINT arg0, ADDRINT arg1)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 4);
+    r[0] = DT_Header(tailCall ? DT_TAILCALL : DT_CALL, 0, id);
+    r[1] = icount.Count(threadid);
+    r[2] = arg0;
+    r[3] = arg1;
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmitIndirectCall(THREADID threadid, UINT32 id, ADDRINT target, ADDRINT arg0, ADDRINT arg1)
+{
+    if (!Emit(threadid))
+        return;
+    
+    // Targets are formatted once
+    PIN_GetLock(&stringsLock, threadid + 1);
+    map<ADDRINT, UINT32>::iterator it = targetStrings.find(target);
+    BOOL found = (it != targetStrings.end());
+    UINT32 targetId = found ? it->second : 0;
+    PIN_ReleaseLock(&stringsLock);
+    if (!found)
+    {
+        PIN_LockClient();
+        string s = FormatAddress(target, RTN_FindByAddress(target));
+        PIN_UnlockClient();
+        targetId = AddString(s);
+        PIN_GetLock(&stringsLock, threadid + 1);
+        targetStrings[target] = targetId;
+        PIN_ReleaseLock(&stringsLock);
+    }
+    
+    UINT64 * r = BinaryRecord(threadid, 5);
+    r[0] = DT_Header(DT_ICALL, 0, id);
+    r[1] = icount.Count(threadid);
+    r[2] = targetId;
+    r[3] = arg0;
+    r[4] = arg1;
+    BinaryDone(threadid);
+}
+
+VOID BinaryEmitReturn(THREADID threadid, UINT32 id, ADDRINT ret0)
+{
+    if (!Emit(threadid))
+        return;
+    
+    UINT64 * r = BinaryRecord(threadid, 3);
+    r[0] = DT_Header(DT_RETURN, 0, id);
+    r[1] = icount.Count(threadid);
+    r[2] = ret0;
+    BinaryDone(threadid);
+}
+
 VOID EmitReturn(THREADID threadid, string * str, ADDRINT ret0)
 {
     if (!Emit(threadid))
@@ -557,9 +854,14 @@ VOID CallTrace(TRACE trace, INS ins)
         string s = "Call " + FormatAddress(INS_Address(ins), TRACE_Rtn(trace));
         s += " -> ";
 
-        INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitIndirectCall), IARG_THREAD_ID,
-                       IARG_PTR, new string(s), IARG_BRANCH_TARGET_ADDR,
-                       IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
+        if (KnobBinary)
+            INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(BinaryEmitIndirectCall), IARG_THREAD_ID,
+                           IARG_UINT32, AddString(s), IARG_BRANCH_TARGET_ADDR,
+                           IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
+        else
+            INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitIndirectCall), IARG_THREAD_ID,
+                           IARG_PTR, new string(s), IARG_BRANCH_TARGET_ADDR,
+                           IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
     }
     else if (INS_IsDirectBranchOrCall(ins))
     {
@@ -599,9 +901,14 @@ VOID CallTrace(TRACE trace, INS ins)
         
             s += FormatAddress(target, RTN_FindByAddress(target));
 
-            INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitDirectCall),
-                           IARG_THREAD_ID, IARG_PTR, new string(s), IARG_BOOL, tailcall,
-                           IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
+            if (KnobBinary)
+                INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(BinaryEmitDirectCall),
+                               IARG_THREAD_ID, IARG_UINT32, AddString(s), IARG_BOOL, tailcall,
+                               IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
+            else
+                INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitDirectCall),
+                               IARG_THREAD_ID, IARG_PTR, new string(s), IARG_BOOL, tailcall,
+                               IARG_G_ARG0_CALLER, IARG_G_ARG1_CALLER, IARG_END);
         }
     }
     else if (INS_IsRet(ins))
@@ -613,8 +920,12 @@ VOID CallTrace(TRACE trace, INS ins)
         if( RTN_Valid(rtn) && RTN_Name(rtn) ==  "_dl_runtime_resolve") return;
 #endif
         string tracestring = "Return " + FormatAddress(INS_Address(ins), rtn);
-        INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitReturn),
-                       IARG_THREAD_ID, IARG_PTR, new string(tracestring), IARG_G_RESULT0, IARG_END);
+        if (KnobBinary)
+            INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(BinaryEmitReturn),
+                           IARG_THREAD_ID, IARG_UINT32, AddString(tracestring), IARG_G_RESULT0, IARG_END);
+        else
+            INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(EmitReturn),
+                           IARG_THREAD_ID, IARG_PTR, new string(tracestring), IARG_G_RESULT0, IARG_END);
     }
 }
         
@@ -690,28 +1001,31 @@ VOID MemoryTrace(INS ins)
     if (!KnobTraceMemory)
         return;
     
+    AFUNPTR emitWrite = KnobBinary ? AFUNPTR(BinaryEmitWrite) : AFUNPTR(EmitWrite);
+    AFUNPTR emitRead = KnobBinary ? AFUNPTR(BinaryEmitRead) : AFUNPTR(EmitRead);
+
     if (INS_IsMemoryWrite(ins) && INS_IsStandardMemop(ins))
     {
         INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(CaptureWriteEa), IARG_THREAD_ID, IARG_MEMORYWRITE_EA, IARG_END);
 
         if (INS_HasFallThrough(ins))
         {
-            INS_InsertPredicatedCall(ins, IPOINT_AFTER, AFUNPTR(EmitWrite), IARG_THREAD_ID, IARG_MEMORYWRITE_SIZE, IARG_END);
+            INS_InsertPredicatedCall(ins, IPOINT_AFTER, emitWrite, IARG_THREAD_ID, IARG_MEMORYWRITE_SIZE, IARG_END);
         }
         if (INS_IsBranchOrCall(ins))
         {
-            INS_InsertPredicatedCall(ins, IPOINT_TAKEN_BRANCH, AFUNPTR(EmitWrite), IARG_THREAD_ID, IARG_MEMORYWRITE_SIZE, IARG_END);
+            INS_InsertPredicatedCall(ins, IPOINT_TAKEN_BRANCH, emitWrite, IARG_THREAD_ID, IARG_MEMORYWRITE_SIZE, IARG_END);
         }
     }
 
     if (INS_HasMemoryRead2(ins) && INS_IsStandardMemop(ins))
     {
-        INS_InsertPredicatedCall(ins, IPOINT_BEFORE, AFUNPTR(EmitRead), IARG_THREAD_ID, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+        INS_InsertPredicatedCall(ins, IPOINT_BEFORE, emitRead, IARG_THREAD_ID, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE, IARG_END);
     }
 
     if (INS_IsMemoryRead(ins) && !INS_IsPrefetch(ins) && INS_IsStandardMemop(ins))
     {
-        INS_InsertPredicatedCall(ins, IPOINT_BEFORE, AFUNPTR(EmitRead), IARG_THREAD_ID, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+        INS_InsertPredicatedCall(ins, IPOINT_BEFORE, emitRead, IARG_THREAD_ID, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
     }
 }
 
@@ -742,8 +1056,20 @@ VOID Trace(TRACE trace, VOID *v)
 
 /* ===================================================================== */
 
+VOID ThreadFini(THREADID threadid, const CONTEXT *, INT32, VOID *)
+{
+    if (buffers[threadid].file)
+        BinaryFlush(threadid);
+}
+
 VOID Fini(int, VOID * v)
 {
+    if (KnobBinary)
+    {
+        BinaryClose();
+        return;
+    }
+
     out << "# $eof" <<  endl;
 
     out.close();
@@ -760,6 +1086,28 @@ static void OnSig(THREADID threadIndex,
                   INT32 sig, 
                   VOID *v)
 {
+    if (KnobBinary)
+    {
+        UINT32 code = DT_SIGNAL_OTHER;
+        switch (reason)
+        {
+          case CONTEXT_CHANGE_REASON_FATALSIGNAL: code = DT_SIGNAL_FATAL; break;
+          case CONTEXT_CHANGE_REASON_SIGNAL: code = DT_SIGNAL_SIGNAL; break;
+          case CONTEXT_CHANGE_REASON_SIGRETURN: code = DT_SIGNAL_SIGRETURN; break;
+          case CONTEXT_CHANGE_REASON_APC: code = DT_SIGNAL_APC; break;
+          case CONTEXT_CHANGE_REASON_EXCEPTION: code = DT_SIGNAL_EXCEPTION; break;
+          case CONTEXT_CHANGE_REASON_CALLBACK: code = DT_SIGNAL_CALLBACK; break;
+          default: break;
+        }
+        UINT64 * r = BinaryRecord(threadIndex, 4);
+        r[0] = DT_Header(DT_SIGNAL, code, 0);
+        r[1] = (ctxtFrom != 0);
+        r[2] = sig;
+        r[3] = ctxtFrom ? PIN_GetContextReg(ctxtFrom, REG_INST_PTR) : 0;
+        BinaryDone(threadIndex);
+        return;
+    }
+
     if (ctxtFrom != 0)
     {
         ADDRINT address = PIN_GetContextReg(ctxtFrom, REG_INST_PTR);
@@ -821,9 +1169,18 @@ int main(int argc, CHAR *argv[])
     }
 
     // Do this before we activate controllers
-    out.open(filename.c_str());
-    out << hex << right;
-    out.setf(ios::showbase);
+    if (KnobBinary)
+    {
+        binaryBase = filename;
+        PIN_InitLock(&stringsLock);
+        PIN_AddThreadFiniFunction(ThreadFini, 0);
+    }
+    else
+    {
+        out.open(filename.c_str());
+        out << hex << right;
+        out.setf(ios::showbase);
+    }
 
     control.RegisterHandler(Handler, 0, FALSE);
     control.Activate();
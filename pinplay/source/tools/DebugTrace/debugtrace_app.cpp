@@ -0,0 +1,71 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*! @file
+ *  A single-threaded application for debugtrace_binary.test: the work
+ *  between the two markers touches only the static table and the stack,
+ *  so with ASLR disabled its trace is the same in every run.
+ */
+
+extern "C" {
+void marker_start_tracing()
+{
+}
+
+void marker_stop_tracing()
+{
+}
+} // end of extern "C"
+
+static unsigned char bytes[64];
+static unsigned short shorts[64];
+static unsigned int words[64];
+static unsigned long long quads[64];
+
+static unsigned long long Mix(unsigned int i)
+{
+    bytes[i] = static_cast<unsigned char>(bytes[(i + 63) % 64] * 3 + i);
+    shorts[i] = static_cast<unsigned short>(shorts[(i + 63) % 64] * 5 + bytes[i]);
+    words[i] = words[(i + 63) % 64] * 7 + shorts[i];
+    quads[i] = quads[(i + 63) % 64] * 11 + words[i];
+    return quads[i];
+}
+
+int main()
+{
+    unsigned long long sum = 0;
+
+    marker_start_tracing();
+    for (unsigned int i = 0; i < 64; i++)
+        sum += Mix(i);
+    marker_stop_tracing();
+
+    return sum == 0;
+}
@@ -0,0 +1,99 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*! @file
+ *  Record layout of the binary trace written by debugtrace -binary and
+ *  read by debugtrace_decode.
+ *
+ *  Every thread writes <o>.<tid>.bin: the magic, the thread id and then a
+ *  sequence of records of 64 bit words. The first word of a record holds
+ *  its kind (bits 0-7), a small argument (bits 8-31) and a string table
+ *  id (bits 32-63):
+ *
+ *    DT_INS       arg=register count, id=instruction; register values
+ *    DT_XMM       arg=register number; low, high quadword
+ *    DT_READ      arg=size; ea, size bytes of data padded to words
+ *    DT_WRITE     arg=size; ea, size bytes of data padded to words
+ *    DT_CALL      id=call string; icount, arg0, arg1
+ *    DT_TAILCALL  id=call string; icount, arg0, arg1
+ *    DT_ICALL     id=call string; icount, target string id, arg0, arg1
+ *    DT_RETURN    id=return string; icount, result
+ *    DT_SIGNAL    arg=DT_SIGNAL_REASON; has address, signal, address
+ *
+ *  The string table, <o>.strings, holds for every id a line "<id> <n>"
+ *  followed by n lines. An instruction has its formatted text followed by
+ *  the names of the registers it writes.
+ */
+
+#ifndef DEBUGTRACE_BINARY_H
+#define DEBUGTRACE_BINARY_H
+
+#include <stdint.h>
+
+#define DT_MAGIC "DTRACE01"
+#define DT_MAGIC_SIZE 8
+
+enum DT_KIND
+{
+    DT_INS = 1,
+    DT_XMM,
+    DT_READ,
+    DT_WRITE,
+    DT_CALL,
+    DT_TAILCALL,
+    DT_ICALL,
+    DT_RETURN,
+    DT_SIGNAL
+};
+
+enum DT_SIGNAL_REASON
+{
+    DT_SIGNAL_OTHER,
+    DT_SIGNAL_FATAL,
+    DT_SIGNAL_SIGNAL,
+    DT_SIGNAL_SIGRETURN,
+    DT_SIGNAL_APC,
+    DT_SIGNAL_EXCEPTION,
+    DT_SIGNAL_CALLBACK
+};
+
+inline uint64_t DT_Header(uint32_t kind, uint32_t arg, uint32_t id)
+{
+    return (static_cast<uint64_t>(id) << 32) | ((arg & 0xffffff) << 8) | (kind & 0xff);
+}
+
+inline uint32_t DT_Kind(uint64_t header) { return header & 0xff; }
+inline uint32_t DT_Arg(uint64_t header) { return (header >> 8) & 0xffffff; }
+inline uint32_t DT_Id(uint64_t header) { return header >> 32; }
+
+/* Number of words holding size bytes of memory data. */
+inline uint32_t DT_DataWords(uint32_t size) { return (size + 7) / 8; }
+
+#endif
@@ -0,0 +1,378 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*! @file
+ *  Decodes the binary trace of debugtrace -binary into the text debugtrace
+ *  writes without it. Each thread file is decoded in turn, so the threads
+ *  are not interleaved; with more than one file a "# thread" line starts
+ *  each of them.
+ *
+ *  Usage: debugtrace_decode [-o <output>] <o>.strings <o>.<tid>.bin ...
+ */
+
+#include "debugtrace_binary.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static vector<vector<string> > strings;
+
+static void Die(const string & msg)
+{
+    cerr << "debugtrace_decode: " << msg << endl;
+    exit(1);
+}
+
+static void ReadStrings(const char * filename)
+{
+    ifstream in(filename);
+    if (!in)
+        Die(string("cannot open ") + filename);
+    string line;
+    while (getline(in, line))
+    {
+        istringstream header(line);
+        uint32_t id, n;
+        if (!(header >> id >> n) || id != strings.size())
+            Die(string("bad string table ") + filename);
+        strings.push_back(vector<string>());
+        for (uint32_t i = 0; i < n && getline(in, line); i++)
+            strings.back().push_back(line);
+        if (strings.back().size() != n)
+            Die(string("truncated string table ") + filename);
+    }
+}
+
+static const vector<string> & String(uint32_t id)
+{
+    if (id >= strings.size() || strings[id].empty())
+        Die("bad string id");
+    return strings[id];
+}
+
+class DECODER
+{
+  public:
+    DECODER(ifstream & in, ostream & out, uint64_t tid)
+        : _in(in), _out(out), _tid(tid), _indent(0) {}
+
+    void Decode()
+    {
+        uint64_t header;
+        while (Read(&header))
+        {
+            switch (DT_Kind(header))
+            {
+              case DT_INS: Instruction(header); break;
+              case DT_XMM: Xmm(header); break;
+              case DT_READ: Read(header); break;
+              case DT_WRITE: Write(header); break;
+              case DT_CALL:
+              case DT_TAILCALL: DirectCall(header); break;
+              case DT_ICALL: IndirectCall(header); break;
+              case DT_RETURN: Return(header); break;
+              case DT_SIGNAL: Signal(header); break;
+              default: Die("bad record");
+            }
+        }
+    }
+
+  private:
+    ifstream & _in;
+    ostream & _out;
+    uint64_t _tid;
+    int _indent;
+
+    bool Read(uint64_t * word)
+    {
+        return _in.read(reinterpret_cast<char *>(word), sizeof(*word)).gcount() == sizeof(*word);
+    }
+
+    uint64_t Next()
+    {
+        uint64_t word;
+        if (!Read(&word))
+            Die("truncated record");
+        return word;
+    }
+
+    void Instruction(uint64_t header)
+    {
+        const vector<string> & s = String(DT_Id(header));
+        uint32_t n = DT_Arg(header);
+        if (s.size() != n + 1)
+            Die("bad register count");
+        _out << s[0];
+        for (uint32_t i = 0; i < n; i++)
+            _out << (i ? ", " : " | ") << s[i + 1] << " = " << Next();
+        _out << endl;
+    }
+
+    void Xmm(uint64_t header)
+    {
+        uint8_t bytes[16];
+        uint64_t words[2];
+        words[0] = Next();
+        words[1] = Next();
+        memcpy(bytes, words, sizeof(bytes));
+        _out << "\t\t\tXMM" << dec << DT_Arg(header) << " := " << setfill('0') << hex;
+        _out.unsetf(ios::showbase);
+        for (int i = 0; i < 16; i++)
+        {
+            if (i == 4 || i == 8 || i == 12)
+                _out << "_";
+            _out << setw(2) << (int)bytes[15 - i];
+        }
+        _out << setfill(' ') << endl;
+        _out.setf(ios::showbase);
+    }
+
+    // The data of a memory record
+    void Data(uint32_t size, vector<uint8_t> & bytes)
+    {
+        vector<uint64_t> words(DT_DataWords(size));
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] = Next();
+        bytes.resize(words.size() * 8);
+        if (!words.empty())
+            memcpy(&bytes[0], &words[0], bytes.size());
+    }
+
+    void ShowN(uint32_t n, void * ea, const vector<uint8_t> & x)
+    {
+        _out.unsetf(ios::showbase);
+        _out << setfill('0');
+        for (uint32_t i = 0; i < n; i++)
+        {
+            _out << setw(2) << static_cast<uint32_t>(x[n - i - 1]);
+            if (((reinterpret_cast<uintptr_t>(ea) + n - i - 1) & 0x3) == 0 && i < n - 1)
+                _out << "_";
+        }
+        _out << setfill(' ');
+        _out.setf(ios::showbase);
+    }
+
+    template <typename T> static T Value(const vector<uint8_t> & x)
+    {
+        T v;
+        memcpy(&v, &x[0], sizeof(v));
+        return v;
+    }
+
+    void Write(uint64_t header)
+    {
+        uint32_t size = DT_Arg(header);
+        void * ea = reinterpret_cast<void *>(static_cast<uintptr_t>(Next()));
+        vector<uint8_t> x;
+        Data(size, x);
+
+        _out << "                                 Write ";
+        switch (size)
+        {
+          case 0:
+            _out << "0 repeat count" << endl;
+            break;
+          case 1:
+            _out << "*(UINT8*)" << ea << " = " << static_cast<uint32_t>(x[0]) << endl;
+            break;
+          case 2:
+            _out << "*(UINT16*)" << ea << " = " << Value<uint16_t>(x) << endl;
+            break;
+          case 4:
+            _out << "*(UINT32*)" << ea << " = " << Value<uint32_t>(x) << endl;
+            break;
+          case 8:
+            _out << "*(UINT64*)" << ea << " = " << Value<uint64_t>(x) << endl;
+            break;
+          default:
+            _out << "*(UINT" << dec << size * 8 << hex << ")" << ea << " = ";
+            ShowN(size, ea, x);
+            _out << endl;
+            break;
+        }
+    }
+
+    void Read(uint64_t header)
+    {
+        uint32_t size = DT_Arg(header);
+        void * ea = reinterpret_cast<void *>(static_cast<uintptr_t>(Next()));
+        vector<uint8_t> x;
+        Data(size, x);
+
+        _out << "                                 Read ";
+        switch (size)
+        {
+          case 0:
+            _out << "0 repeat count" << endl;
+            break;
+          case 1:
+            _out << static_cast<uint32_t>(x[0]) << " = *(UINT8*)" << ea << endl;
+            break;
+          case 2:
+            _out << Value<uint16_t>(x) << " = *(UINT16*)" << ea << endl;
+            break;
+          case 4:
+            _out << Value<uint32_t>(x) << " = *(UINT32*)" << ea << endl;
+            break;
+          case 8:
+            _out << Value<uint64_t>(x) << " = *(UINT64*)" << ea << endl;
+            break;
+          default:
+            ShowN(size, ea, x);
+            _out << " = *(UINT" << dec << size * 8 << hex << ")" << ea << endl;
+            break;
+        }
+    }
+
+    void Indent()
+    {
+        for (int i = 0; i < _indent; i++)
+            _out << "| ";
+    }
+
+    void ICount(uint64_t count)
+    {
+        _out << setw(10) << dec << count << hex << " ";
+    }
+
+    void DirectCall(uint64_t header)
+    {
+        const string & s = String(DT_Id(header))[0];
+        ICount(Next());
+        uint64_t arg0 = Next();
+        uint64_t arg1 = Next();
+        if (DT_Kind(header) == DT_TAILCALL)
+        {
+            // A tail call is like an implicit return followed by an immediate call
+            _indent--;
+        }
+        Indent();
+        _out << s << "(" << arg0 << ", " << arg1 << ", ...)" << endl;
+        _indent++;
+    }
+
+    void IndirectCall(uint64_t header)
+    {
+        const string & s = String(DT_Id(header))[0];
+        ICount(Next());
+        const string & target = String(Next())[0];
+        uint64_t arg0 = Next();
+        uint64_t arg1 = Next();
+        Indent();
+        _out << s << target << "(" << arg0 << ", " << arg1 << ", ...)" << endl;
+        _indent++;
+    }
+
+    void Return(uint64_t header)
+    {
+        const string & s = String(DT_Id(header))[0];
+        ICount(Next());
+        uint64_t ret0 = Next();
+        _indent--;
+        if (_indent < 0)
+        {
+            _out << "@@@ return underflow\n";
+            _indent = 0;
+        }
+        Indent();
+        _out << s << " returns: " << ret0 << endl;
+    }
+
+    void Signal(uint64_t header)
+    {
+        bool hasAddress = Next();
+        uint64_t sig = Next();
+        uint64_t address = Next();
+        if (hasAddress)
+        {
+            _out << "SIG signal=" << sig << " on thread " << _tid
+                 << " at address " << hex << address << dec << " ";
+        }
+        switch (DT_Arg(header))
+        {
+          case DT_SIGNAL_FATAL: _out << "FATALSIG" << sig; break;
+          case DT_SIGNAL_SIGNAL: _out << "SIGNAL " << sig; break;
+          case DT_SIGNAL_SIGRETURN: _out << "SIGRET"; break;
+          case DT_SIGNAL_APC: _out << "APC"; break;
+          case DT_SIGNAL_EXCEPTION: _out << "EXCEPTION"; break;
+          case DT_SIGNAL_CALLBACK: _out << "CALLBACK"; break;
+          default: break;
+        }
+        _out << std::endl;
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    int arg = 1;
+    ofstream file;
+    if (arg + 1 < argc && string(argv[arg]) == "-o")
+    {
+        file.open(argv[arg + 1]);
+        if (!file)
+            Die(string("cannot open ") + argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 2)
+    {
+        cerr << "Usage: debugtrace_decode [-o <output>] <o>.strings <o>.<tid>.bin ..." << endl;
+        return 1;
+    }
+    ostream & out = file.is_open() ? static_cast<ostream &>(file) : cout;
+    out << hex << right;
+    out.setf(ios::showbase);
+
+    ReadStrings(argv[arg++]);
+    bool several = (argc - arg > 1);
+    for (; arg < argc; arg++)
+    {
+        ifstream in(argv[arg], ios::in | ios::binary);
+        char magic[DT_MAGIC_SIZE];
+        uint64_t tid;
+        if (!in.read(magic, DT_MAGIC_SIZE) || memcmp(magic, DT_MAGIC, DT_MAGIC_SIZE) != 0 ||
+            !in.read(reinterpret_cast<char *>(&tid), sizeof(tid)))
+        {
+            Die(string("not a debugtrace binary trace: ") + argv[arg]);
+        }
+        if (several)
+            out << "# thread " << dec << tid << hex << endl;
+        DECODER decoder(in, out, tid);
+        decoder.Decode();
+    }
+    out << "# $eof" << endl;
+    return 0;
+}
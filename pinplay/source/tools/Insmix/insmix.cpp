@@ -80,12 +80,6 @@ KNOB<UINT32> KnobNumInstructions(KNOB_MODE_WRITEONCE,    "pintool",
 
 LOCALFUN string longstr(int rtn_no, const char *name) {return string("rtn[") + decstr(rtn_no) + string(",") + string(name) + string("]");}
 
-// The running count of instructions is kept here
-// make it static to help the compiler optimize count_instructions
-static UINT64 inscount = 0;
-
-// This function is called before every block
-VOID count_instructions(UINT32 c) { inscount += c; }
 
 /* ===================================================================== */
 
@@ -265,7 +259,8 @@ class  RTN_TABLE_ENTRY
      RTN_TABLE_ENTRY(ADDRINT address, const char *name):_address(address), _name(name) { }
 };
 
-map<UINT32, RTN_TABLE_ENTRY *> rtn_table;
+// indexed by RTN_Id
+LOCALVAR vector<RTN_TABLE_ENTRY *> rtn_table;
 
 class BBLSTATS
 {
@@ -276,10 +271,14 @@ class BBLSTATS
     const UINT32 _rtn_num;
     const UINT32 _size;
     const UINT32 _numins;
+    const UINT32 _slot;            // first of the counters of the bbl in every thread
+    const UINT16 * const _predicated; // opcodes of the predicated instructions, 0 terminated
 
   public:
-    BBLSTATS(UINT16 * stats, ADDRINT addr, UINT32 rtn_num, UINT32 size, UINT32 numins ) :
-        _counter(0), _stats(stats), _addr(addr), _rtn_num(rtn_num), _size(size),_numins(numins)  {};
+    BBLSTATS(UINT16 * stats, ADDRINT addr, UINT32 rtn_num, UINT32 size, UINT32 numins,
+             UINT32 slot, UINT16 * predicated ) :
+        _counter(0), _stats(stats), _addr(addr), _rtn_num(rtn_num), _size(size),_numins(numins),
+        _slot(slot), _predicated(predicated) {};
 
 };
 
@@ -289,6 +288,93 @@ LOCALFUN BOOL CompareLess(const BBLSTATS * const & s1 , const BBLSTATS *const &
         return ((rtn_table[s1->_rtn_num]->_address) <  (rtn_table[s2->_rtn_num]->_address));
 }
 
+/* ===================================================================== */
+/* Per thread counters */
+/* ===================================================================== */
+
+/*
+  Every bbl owns a block of consecutive counter slots: its execution count
+  followed by one count per predicated instruction (-p). Every thread has
+  its own counters for all the slots, in chunks that are allocated for all
+  the threads at instrumentation time, as the bbls show up, and for a new
+  thread when it starts. The analysis routines reach the counters of the
+  thread through a tool register and never allocate. The counters are
+  summed into the BBLSTATS at the end.
+*/
+
+const UINT32 COUNTER_CHUNK_BITS = 12;
+const UINT32 COUNTER_CHUNK_SIZE = 1 << COUNTER_CHUNK_BITS;
+const UINT32 COUNTER_MAX_CHUNKS = 4096;
+
+class THREAD_STATS
+{
+  public:
+    UINT64 _inscount;   // all the instructions, also outside of the regions
+    COUNTER * _chunks[COUNTER_MAX_CHUNKS];
+
+    THREAD_STATS() : _inscount(0)
+    {
+        memset(_chunks, 0, sizeof(_chunks));
+    }
+
+    VOID AddChunk(UINT32 chunk)
+    {
+        if (_chunks[chunk])
+            return;
+        _chunks[chunk] = new COUNTER[COUNTER_CHUNK_SIZE];
+        memset(_chunks[chunk], 0, COUNTER_CHUNK_SIZE * sizeof(COUNTER));
+    }
+
+    COUNTER Count(UINT32 slot) const
+    {
+        const COUNTER * chunk = _chunks[slot >> COUNTER_CHUNK_BITS];
+        if (!chunk)
+            return 0;
+        return chunk[slot & (COUNTER_CHUNK_SIZE - 1)];
+    }
+};
+
+LOCALVAR THREAD_STATS * threadStats[PIN_MAX_THREADS];
+LOCALVAR UINT32 numSlots = 0;
+LOCALVAR UINT32 numChunks = 0;   // chunks allocated in every thread
+LOCALVAR REG statsReg;           // THREAD_STATS of the thread
+
+// Allocate the chunks holding slots [0, numSlots) in every thread
+LOCALFUN VOID AddChunks()
+{
+    while ((numChunks << COUNTER_CHUNK_BITS) < numSlots)
+    {
+        ASSERT(numChunks < COUNTER_MAX_CHUNKS, "Too many bbls\n");
+        for (THREADID tid = 0; tid < PIN_MAX_THREADS; tid++)
+        {
+            if (threadStats[tid])
+                threadStats[tid]->AddChunk(numChunks);
+        }
+        numChunks++;
+    }
+}
+
+LOCALFUN UINT64 TotalInscount()
+{
+    UINT64 total = 0;
+    for (THREADID tid = 0; tid < PIN_MAX_THREADS; tid++)
+    {
+        if (threadStats[tid])
+            total += threadStats[tid]->_inscount;
+    }
+    return total;
+}
+
+// A reused thread id keeps counting in the same THREAD_STATS
+LOCALFUN VOID ThreadStart(THREADID tid, CONTEXT *ctxt, INT32 flags, VOID *v)
+{
+    if (!threadStats[tid])
+        threadStats[tid] = new THREAD_STATS();
+    for (UINT32 chunk = 0; chunk < numChunks; chunk++)
+        threadStats[tid]->AddChunk(chunk);
+    PIN_SetContextReg(ctxt, statsReg, reinterpret_cast<ADDRINT>(threadStats[tid]));
+}
+
 
 LOCALVAR vector<const BBLSTATS*> statsList;
 
@@ -319,9 +405,41 @@ LOCALVAR CONTROL_MANAGER control;
 
 
 /* ===================================================================== */
-VOID PIN_FAST_ANALYSIS_CALL docount(COUNTER * counter)
+// Called before every bbl
+VOID PIN_FAST_ANALYSIS_CALL docount_bbl(THREAD_STATS * stats, UINT32 chunk, UINT32 offset,
+                                        UINT32 numins)
+{
+    stats->_inscount += numins;
+    stats->_chunks[chunk][offset] += enabled;
+}
+
+VOID PIN_FAST_ANALYSIS_CALL docount_predicated(THREAD_STATS * stats, UINT32 chunk, UINT32 offset)
 {
-    (*counter) += enabled;
+    stats->_chunks[chunk][offset] += enabled;
+}
+
+// Sum the counters of all threads into the bbls
+LOCALFUN VOID MergeThreadCounts()
+{
+    for (vector<const BBLSTATS*>::iterator bi = statsList.begin(); bi != statsList.end(); bi++)
+    {
+        BBLSTATS *b = const_cast<BBLSTATS*>(*bi);
+        if (b == 0) break; // sentinel
+
+        b->_counter = 0;
+        for (THREADID tid = 0; tid < PIN_MAX_THREADS; tid++)
+        {
+            const THREAD_STATS * stats = threadStats[tid];
+            if (!stats)
+                continue;
+            b->_counter += stats->Count(b->_slot);
+            UINT32 slot = b->_slot + 1;
+            for (const UINT16 * opcode = b->_predicated; *opcode; opcode++, slot++)
+            {
+                GlobalStatsDynamic.predicated_true[*opcode] += stats->Count(slot);
+            }
+        }
+    }
 }
 
 /* ===================================================================== */
@@ -332,7 +450,7 @@ VOID Trace(TRACE trace, VOID *v)
          && IMG_Type(SEC_Img(RTN_Sec(TRACE_Rtn(trace)))) == IMG_TYPE_SHAREDLIB)
         return;
 
-    if ( KnobNumInstructions.Value() > 0 && inscount > KnobNumInstructions.Value())
+    if ( KnobNumInstructions.Value() > 0 && TotalInscount() > KnobNumInstructions.Value())
         PIN_Detach();
 
     RTN rtn = TRACE_Rtn(trace);
@@ -352,8 +470,11 @@ VOID Trace(TRACE trace, VOID *v)
         rtn_address = RTN_Address(rtn);
         rtn_name = RTN_Name(rtn).c_str();
     }
-    map<UINT32, RTN_TABLE_ENTRY *>::const_iterator it = rtn_table.find(rtn_num);
-    if (it == rtn_table.end())
+    if (rtn_num >= rtn_table.size())
+    {
+        rtn_table.resize(rtn_num + 1, 0);
+    }
+    if (!rtn_table[rtn_num])
     {
        char *str = new char [ strlen(rtn_name) + 1];
        strcpy(str, rtn_name);
@@ -364,9 +485,6 @@ VOID Trace(TRACE trace, VOID *v)
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
     {
-        // Insert a call to count_instructions before every bbl, passing the number of instructions
-        BBL_InsertCall(bbl, IPOINT_BEFORE, (AFUNPTR)count_instructions, IARG_UINT32, BBL_NumIns(bbl), IARG_END);
-
         // Summarize the stats for the bbl in a 0 terminated list
         // This is done at instrumentation time
         const UINT32 n = IndexStringLength(bbl, 1);
@@ -378,6 +496,9 @@ VOID Trace(TRACE trace, VOID *v)
         UINT32 numins = 0;
         UINT32 size = 0;
 
+        const UINT32 slot = numSlots++;
+        vector<UINT16> predicated;
+
         for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
         {
             if ((INS_IsMemoryRead(ins) || INS_IsMemoryWrite(ins)) && !INS_IsStandardMemop(ins))
@@ -390,11 +511,15 @@ VOID Trace(TRACE trace, VOID *v)
             // this is expensive and hence disabled by default
             if( INS_IsPredicated(ins) && accurate_handling_of_predicates )
             {
+                const UINT32 predicatedSlot = numSlots++;
                 INS_InsertPredicatedCall(ins,
                                          IPOINT_BEFORE,
-                                         AFUNPTR(docount), IARG_FAST_ANALYSIS_CALL, 
-                                         IARG_PTR, &(GlobalStatsDynamic.predicated_true[INS_Opcode(ins)]),
+                                         AFUNPTR(docount_predicated), IARG_FAST_ANALYSIS_CALL, 
+                                         IARG_REG_VALUE, statsReg,
+                                         IARG_UINT32, predicatedSlot >> COUNTER_CHUNK_BITS,
+                                         IARG_UINT32, predicatedSlot & (COUNTER_CHUNK_SIZE - 1),
                                          IARG_END);
+                predicated.push_back(INS_Opcode(ins));
             }
 
             curr = INS_GenerateIndexString(ins,curr,1);
@@ -405,14 +530,29 @@ VOID Trace(TRACE trace, VOID *v)
 
         ASSERTX( curr == stats_end );
 
+        UINT16 * const predicated_opcodes = new UINT16[predicated.size() + 1];
+        for (UINT32 i = 0; i < predicated.size(); i++)
+            predicated_opcodes[i] = predicated[i];
+        predicated_opcodes[predicated.size()] = 0;
+
         // Insert instrumentation to count the number of times the bbl is executed
-        BBLSTATS * bblstats = new BBLSTATS(stats, INS_Address(BBL_InsHead(bbl)), rtn_num, size, numins );
-        INS_InsertCall(BBL_InsHead(bbl), IPOINT_BEFORE, AFUNPTR(docount), IARG_FAST_ANALYSIS_CALL, IARG_PTR, &(bblstats->_counter), IARG_END);
+        // and the instructions it executes
+        BBLSTATS * bblstats = new BBLSTATS(stats, INS_Address(BBL_InsHead(bbl)), rtn_num, size, numins,
+                                           slot, predicated_opcodes );
+        INS_InsertCall(BBL_InsHead(bbl), IPOINT_BEFORE, AFUNPTR(docount_bbl), IARG_FAST_ANALYSIS_CALL,
+                       IARG_REG_VALUE, statsReg,
+                       IARG_UINT32, slot >> COUNTER_CHUNK_BITS,
+                       IARG_UINT32, slot & (COUNTER_CHUNK_SIZE - 1),
+                       IARG_UINT32, BBL_NumIns(bbl),
+                       IARG_END);
 
         // Remember the counter and stats so we can compute a summary at the end
         statsList.push_back(bblstats);
     }
 
+    // the counters of the new slots exist before the trace runs
+    AddChunks();
+
 }
 
 
@@ -540,6 +680,8 @@ VOID PrintOutput()
     string filename;
     std::ofstream out;
 
+    MergeThreadCounts();
+
     // dump insmix profile
 
     filename =  KnobOutputFile.Value();
@@ -628,8 +770,17 @@ int main(int argc, CHAR *argv[])
         return Usage();
     }
 
+    statsReg = PIN_ClaimToolRegister();
+    if (!REG_valid(statsReg))
+    {
+        std::cerr << "Cannot allocate a scratch register.\n";
+        std::cerr << std::flush;
+        return 1;
+    }
+
     control.RegisterHandler(Handler, 0, FALSE);
     control.Activate();
+    PIN_AddThreadStartFunction(ThreadStart, 0);
     TRACE_AddInstrumentFunction(Trace, 0);
 
     PIN_AddFiniFunction(Fini, 0);
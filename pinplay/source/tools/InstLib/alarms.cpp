@@ -47,6 +47,8 @@ VOID ALARM_ICOUNT::Activate(){
 
 VOID ALARM_ICOUNT::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_ICOUNT* icount_alarm = static_cast<ALARM_ICOUNT*>(v);
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
     {
@@ -65,6 +67,8 @@ VOID ALARM_SSC::Activate(){
 
 VOID ALARM_SSC::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_SSC* ssc_alarm = static_cast<ALARM_SSC*>(v);
     UINT32 h = Uint32FromString("0x"+ssc_alarm->_ssc);
     const UINT32 pattern_len = 8;
@@ -104,6 +108,8 @@ VOID ALARM_ITEXT::Activate(){
 
 VOID ALARM_ITEXT::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_ITEXT* itext_alarm = static_cast<ALARM_ITEXT*>(v);
     UINT32 pattern_len = itext_alarm->_itext.length();
     UINT32 pattern_bytes = pattern_len / 2; //nibbels -> bytes
@@ -149,8 +155,11 @@ VOID ALARM_INT3::Trace(TRACE trace, VOID* v)
             iclass = static_cast<xed_iclass_enum_t>(INS_Opcode(ins));
             if (iclass == XED_ICLASS_INT3){
                 ALARM_INT3* int3_alarm = static_cast<ALARM_INT3*>(v);
-                InsertIfCall_Count(int3_alarm, ins, 1);
-                InsertThenCall_Fire(int3_alarm, ins);
+                if (IsArmedVersion(trace)){
+                    InsertIfCall_Count(int3_alarm, ins, 1);
+                    InsertThenCall_Fire(int3_alarm, ins);
+                }
+                // the idle version must not execute the "int3" either
                 INS_Delete(ins); // so no "int3" will be actually executed
             }
         }
@@ -165,6 +174,8 @@ VOID ALARM_ISA_CATEGORY::Activate(){
 
 VOID ALARM_ISA_CATEGORY::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_ISA_CATEGORY* isa_ctg_alarm = static_cast<ALARM_ISA_CATEGORY*>(v);
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -189,6 +200,8 @@ VOID ALARM_ISA_EXTENSION::Activate(){
 
 VOID ALARM_ISA_EXTENSION::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_ISA_EXTENSION* isa_ext_alarm = static_cast<ALARM_ISA_EXTENSION*>(v);
     
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -213,6 +226,8 @@ VOID ALARM_ADDRESS::Activate(){
 
 VOID ALARM_ADDRESS::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_ADDRESS* address_alarm = static_cast<ALARM_ADDRESS*>(v);
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -253,6 +268,8 @@ VOID ALARM_SYMBOL::Img(IMG img, VOID* v)
 }
 VOID ALARM_SYMBOL::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_SYMBOL* symbol_alarm = static_cast<ALARM_SYMBOL*>(v);
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -309,6 +326,8 @@ VOID ALARM_IMAGE::Img(IMG img, VOID* v)
 
 VOID ALARM_IMAGE::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_IMAGE* image_alarm = static_cast<ALARM_IMAGE*>(v);
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -335,12 +354,15 @@ VOID ALARM_INTERACTIVE::Activate(){
         PIN_ERROR("interactive controller must be used "
                    "with the knob -interactive_file <file name>\n\n");
     }
+    _event = _alarm_manager->GetEventType();
     
     TRACE_AddInstrumentFunction(Trace, this);
 }
 
 VOID ALARM_INTERACTIVE::Trace(TRACE trace, VOID* v)
 {
+    if (!IsArmedVersion(trace)) return;
+
     ALARM_INTERACTIVE* alarm = static_cast<ALARM_INTERACTIVE*>(v);
 
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
@@ -371,7 +393,7 @@ ALARM_INTERACTIVE::InteractiveShouldFire(ALARM_INTERACTIVE* alarm,
     UINT32 correct_tid = (alarm->_tid == tid) | (alarm->_tid == ALL_THREADS);
 
     if (armed & correct_tid){
-        return alarm->_listener->CheckClearSignal();
+        return alarm->_listener->CheckClearSignal(alarm->_event);
     }
     return 0;
 }
@@ -64,9 +64,10 @@ static void a_on_call(ADDRINT target,
     mngr->on_call(tid, ctxt, target);
 }
 
+// branch-free so it can be inlined; on_call() does the exact lookup
 static ADDRINT a_target_interesting(ADDRINT target, CallStackManager* mngr)
 {
-    return mngr->TargetInteresting(target);
+    return mngr->TargetMayBeInteresting(target);
 }
 
 static ADDRINT a_on_ret_should_fire(THREADID tid, CallStackManager* mngr)
@@ -379,6 +380,10 @@ CallStack CallStackManager::get_stack(THREADID tid){
     return *call_stack; //copy const. 
 }
 
+UINT32 CallStackManager::stack_depth(THREADID tid){
+    return _call_stack_map[tid]->depth();
+}
+
 void CallStackManager::get_ip_info(
     ADDRINT ip,
     CallStackInfo& info)
@@ -475,6 +480,7 @@ void CallStackManager::Img(IMG img, void* v)
             for (UINT32 i = 0; i < mngr->_enter_func_handlers.size(); i++){
                 if (mngr->_enter_func_handlers[i]._function_name == name){
                     mngr->_enter_func_handlers_map[ip].push_back(&mngr->_enter_func_handlers[i]);
+                    mngr->add_to_target_filter(ip);
                 }
             }
 
@@ -482,6 +488,7 @@ void CallStackManager::Img(IMG img, void* v)
             for (UINT32 i = 0; i < mngr->_enter_func_handlers.size(); i++){
                 if (mngr->_enter_func_handlers[i]._function_name == name){
                     mngr->_exit_func_handlers_map[ip].push_back(&mngr->_exit_func_handlers[i]);
+                    mngr->add_to_target_filter(ip);
                 }
             }
         }
@@ -519,7 +526,7 @@ void CallStackManager::on_call(THREADID tid, CONTEXT* ctxt, ADDRINT ip){
     //recored the stack depth if this is a requested exit functioniter = _exit_func_handlers_map.find(ip);
     iter = _exit_func_handlers_map.find(ip);
     if (iter != _exit_func_handlers_map.end()){
-        UINT32 depth = get_stack(tid).depth();
+        UINT32 depth = stack_depth(tid);
         DepthFuncHandlersMap& m = _depth_func_handlers_tid_vec[tid];
         m[depth] = iter->second; //a vector of handlers
         _marked_ip_for_exit.insert(ip);
@@ -532,9 +539,12 @@ void CallStackManager::on_call(THREADID tid, CONTEXT* ctxt, ADDRINT ip){
 // the call-stack beyond the recorded depth.
 // if so,  we return 1 so the  Then instrumentation will be called
 BOOL CallStackManager::on_ret_should_fire(THREADID tid){
-    UINT32 depth = get_stack(tid).depth();
-    DepthFuncHandlersMap::iterator iter;
     DepthFuncHandlersMap& m = _depth_func_handlers_tid_vec[tid];
+    if (m.empty()){
+        return FALSE;
+    }
+    UINT32 depth = stack_depth(tid);
+    DepthFuncHandlersMap::iterator iter;
     
     iter = m.begin();
     //find all handlers that should be called based on the stack depth
@@ -554,7 +564,7 @@ BOOL CallStackManager::on_ret_should_fire(THREADID tid){
 //    1. we call all the registered handlers
 //    2. remove the 'depth' entry so it will not be call again later.
 void CallStackManager::on_ret_fire(THREADID tid, CONTEXT* ctxt, ADDRINT ip){
-    UINT32 depth = get_stack(tid).depth();
+    UINT32 depth = stack_depth(tid);
     DepthFuncHandlersMap::iterator iter;
     DepthFuncHandlersMap::iterator earase_iter;
     DepthFuncHandlersMap& m = _depth_func_handlers_tid_vec[tid];
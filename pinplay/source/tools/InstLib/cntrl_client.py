@@ -4,40 +4,126 @@
 '''
 This script is used as the client side of the SDE interactive controller.
 It allows users to interactively trigger controller event inside an application running under SDE.
- 
+
+Every process of the application maps a command channel file <name>.<pid>.
+A signal fires the next event of the interactive controller chain
+(e.g. start, then stop); several signals can be queued at once.
+A named command (-c) fires only an interactive alarm of that event, so
+the chains of different events can be driven separately.  Commands are
+consumed in order: a command waits until an alarm of its event is armed.
+
 Example:
 > SDE_KIT/sde -control start:interactive -interactive_file <name> -- <app>
-> SDE_KIT/misc/cntrl_client.py <name>
+> SDE_KIT/misc/cntrl_client.py <name>.<pid>      # one process
+> SDE_KIT/misc/cntrl_client.py <name>            # all processes
+> SDE_KIT/misc/cntrl_client.py -n 2 <name>       # two events in every process
+> SDE_KIT/misc/cntrl_client.py -c stats-emit <name>
 '''
 
 import os
 import sys
-import json
-import socket
-
-if len(sys.argv) != 2:
-    print 'Error Usage: python cntrl_client.py <file_name>'
-    exit(1)
-    
-file_name = sys.argv[1]
-if not os.path.exists(file_name):
-    print 'file file: ' + file_name + ' does not exists'
-    print 'Have you run SDE with interactive controller?' 
-    exit(1)
-
-try:
-    sock = None
-    with open(file_name, 'r') as f:
-        content = json.load(f)
-        if (not 'port' in content):
-            raise Exception('Unable to find port in the file')
-        port = int(content['port'])
-        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        sock.connect(('localhost', port))
-        sock.send("1")
-except Exception,e:
-    print 'ERROR: failed sending signal to SDE - ' + e.message
-    if None != sock:
-        sock.close()
-    
-    
+import glob
+import mmap
+import struct
+import time
+import optparse
+
+# must match INTERACTIVE_CHANNEL in interactive_listener.H
+MAGIC = b'PINCTRL1'
+CHANNEL_SIZE = 4096
+HEADER = '<8sIII'      # magic, ring size, pid, head
+HEAD_OFFSET = 16
+RING_OFFSET = 64
+COMMAND_SIGNAL = 1
+COMMAND_EVENT = 2
+
+# EVENT_TYPE in controller_events.H; a command is COMMAND_EVENT + event
+EVENTS = {
+    'start': 2,
+    'stop': 3,
+    'warmup-start': 5,
+    'warmup-stop': 6,
+    'prolog-start': 7,
+    'prolog-stop': 8,
+    'epilog-start': 9,
+    'epilog-stop': 10,
+    'stats-reset': 11,
+    'stats-emit': 12,
+}
+
+
+def channel_files(name):
+    '''Return the channel files for name: the file itself if it exists,
+    otherwise the files of all processes, <name>.<pid>.'''
+    if os.path.isfile(name):
+        return [name]
+    return sorted(f for f in glob.glob(name + '.*')
+                  if os.path.basename(f)[len(os.path.basename(name)) + 1:].isdigit())
+
+
+def send(file_name, command, count, timeout):
+    '''Queue count commands in the channel of one process.'''
+    with open(file_name, 'r+b') as f:
+        m = mmap.mmap(f.fileno(), CHANNEL_SIZE)
+        try:
+            magic, ring_size, pid, head = struct.unpack_from(HEADER, m, 0)
+            if magic != MAGIC:
+                raise Exception('not an interactive controller channel')
+            deadline = time.time() + timeout
+            for _ in range(count):
+                slot = RING_OFFSET + head % ring_size
+                # the tool clears a slot when it consumes the command
+                while ord(m[slot:slot + 1]) != 0:
+                    if time.time() > deadline:
+                        raise Exception('command ring of process %d is full' % pid)
+                    time.sleep(0.01)
+                m[slot:slot + 1] = struct.pack('B', command)
+                head = (head + 1) & 0xffffffff
+                struct.pack_into('<I', m, HEAD_OFFSET, head)
+        finally:
+            m.close()
+    return pid
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] <file_name> [<file_name> ...]')
+    parser.add_option('-n', '--count', type='int', default=1,
+                      help='number of signals to send to each process (default 1)')
+    parser.add_option('-c', '--command', default='signal',
+                      help='event to fire: signal (the next event of the chain), '
+                           + ', '.join(sorted(EVENTS)) + ' (default signal)')
+    parser.add_option('-t', '--timeout', type='float', default=5.0,
+                      help='seconds to wait for room in a full command ring')
+    options, args = parser.parse_args()
+    if not args or options.count < 1:
+        parser.print_usage()
+        return 1
+    if options.command == 'signal':
+        command = COMMAND_SIGNAL
+    elif options.command in EVENTS:
+        command = COMMAND_EVENT + EVENTS[options.command]
+    else:
+        print('unknown command: ' + options.command)
+        parser.print_usage()
+        return 1
+
+    status = 0
+    for name in args:
+        files = channel_files(name)
+        if not files:
+            print('file: ' + name + ' does not exist')
+            print('Have you run SDE with interactive controller?')
+            status = 1
+            continue
+        for file_name in files:
+            try:
+                pid = send(file_name, command, options.count, options.timeout)
+                print('sent %d %s command(s) to process %d' % (options.count, options.command, pid))
+            except Exception as e:
+                print('ERROR: failed sending signal to SDE (' + file_name + ') - ' + str(e))
+                status = 1
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -38,6 +38,75 @@ END_LEGAL */
 
 using namespace CONTROLLER;
 
+REG IALARM::_version_reg = REG_INVALID();
+BOOL IALARM::_versioning_initialized = FALSE;
+UINT32 IALARM::_armed_alarms[PIN_MAX_THREADS];
+PIN_LOCK IALARM::_armed_alarms_lock;
+
+//the version switch must run before any alarm instrumentation
+//(the controller orders its calls from CALL_ORDER_FIRST-50+2)
+static const UINT32 VERSION_CALL_ORDER = CALL_ORDER_FIRST - 50;
+
+VOID IALARM::InitVersioning(){
+    if (_versioning_initialized){
+        return;
+    }
+    _versioning_initialized = TRUE;
+
+    memset(_armed_alarms,0,sizeof(_armed_alarms));
+    PIN_InitLock(&_armed_alarms_lock);
+
+    //without a free tool register all traces stay in the armed version
+    _version_reg = PIN_ClaimToolRegister();
+    if (REG_valid(_version_reg)){
+        TRACE_AddInstrumentFunction(VersionTrace, 0);
+    }
+}
+
+VOID IALARM::VersionTrace(TRACE trace, VOID* v){
+    INS ins = BBL_InsHead(TRACE_BblHead(trace));
+
+    INS_InsertCall(ins, IPOINT_BEFORE,
+        AFUNPTR(ThreadArmed),
+        IARG_FAST_ANALYSIS_CALL,
+        IARG_CALL_ORDER, VERSION_CALL_ORDER,
+        IARG_THREAD_ID,
+        IARG_RETURN_REGS, _version_reg,
+        IARG_END);
+
+    if (IsArmedVersion(trace)){
+        INS_InsertVersionCase(ins, _version_reg, 0, VERSION_IDLE,
+            IARG_CALL_ORDER, VERSION_CALL_ORDER + 1,
+            IARG_END);
+    }
+    else{
+        INS_InsertVersionCase(ins, _version_reg, 1, VERSION_ARMED,
+            IARG_CALL_ORDER, VERSION_CALL_ORDER + 1,
+            IARG_END);
+    }
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IALARM::ThreadArmed(THREADID tid){
+    return _armed_alarms[tid] != 0;
+}
+
+VOID IALARM::SetArmed(THREADID tid, BOOL armed){
+    PIN_GetLock(&_armed_alarms_lock,0);
+    if (_armed[tid] != armed){
+        _armed[tid] = armed;
+        //an alarm bound to another thread never counts in this one
+        if (_tid == tid || _tid == ALL_THREADS){
+            if (armed){
+                _armed_alarms[tid]++;
+            }
+            else{
+                _armed_alarms[tid]--;
+            }
+        }
+    }
+    PIN_ReleaseLock(&_armed_alarms_lock);
+}
+
 
 VOID IALARM::InsertIfCall_Count(IALARM* alarm, INS ins, UINT32 ninst){
     INS_InsertIfCall(ins, IPOINT_BEFORE,
@@ -97,18 +166,26 @@ VOID IALARM::Fire(IALARM* ialarm, CONTEXT* ctxt, VOID * ip, UINT32 tid){
 
 VOID IALARM::Arm(){
     PIN_GetLock(&_lock,0);
-    memset(_armed,1,sizeof(_armed));
+    for (UINT32 tid = 0; tid < PIN_MAX_THREADS; tid++){
+        SetArmed(tid, TRUE);
+    }
     PIN_ReleaseLock(&_lock);
 }
 
+VOID IALARM::Arm(THREADID tid){
+    SetArmed(tid, TRUE);
+}
+
 VOID IALARM::Disarm(THREADID tid){
-    _armed[tid] = 0;
+    SetArmed(tid, FALSE);
     _thread_count[tid]._count = 0;
 }
 
 VOID IALARM::Disarm(){
     PIN_GetLock(&_lock,0);
-    memset(_armed,0,sizeof(_armed));
+    for (UINT32 tid = 0; tid < PIN_MAX_THREADS; tid++){
+        SetArmed(tid, FALSE);
+    }
     memset(_thread_count,0,sizeof(_thread_count));
     PIN_ReleaseLock(&_lock);
 }
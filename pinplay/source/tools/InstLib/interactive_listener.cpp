@@ -32,7 +32,7 @@ END_LEGAL */
 #include "interactive_listener.H"
 
 #if !defined(TARGET_WINDOWS)
-#include <sys/select.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <string.h>
@@ -40,16 +40,6 @@ END_LEGAL */
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
-#include <sys/syscall.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <fstream>
-
-#if !defined(SYS_close)
-#  include <asm/unistd.h>
-#  define SYS_close __NR_close
-#endif
-
 #endif
 
 #if !defined(TARGET_WINDOWS)
@@ -58,20 +48,17 @@ using namespace CONTROLLER;
 VOID INTERACTIVE_LISTENER::Active(){
     _main_pid = PIN_GetPid();
     PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, AfterForkInChild, this);
-   
-    //create new thread that will listen to the socket
-    PIN_SpawnInternalThread(WaitForUserSiganl, this, 0 ,NULL);
-    PIN_AddPrepareForFiniFunction(PrepareForFini,this);
     PIN_AddFiniFunction(Fini,this);
-    PIN_AddSyscallEntryFunction(MonitorFD,this);
+    OpenChannel();
 }
 
-// create the socket and listen to it
-UINT32 INTERACTIVE_LISTENER::OpenSocket(){
+// create the channel file and map it.
+// the descriptor is closed right away, so there is nothing the
+// application can close under our feet.
+VOID INTERACTIVE_LISTENER::OpenChannel(){
 
     UINT32 pid = PIN_GetPid();
     _full_file = _file_name + "." + decstr(pid);
-    UINT32 res;
     if (pid == _main_pid){
         printf("Main process pid: %d\n", pid);
     }
@@ -80,124 +67,48 @@ UINT32 INTERACTIVE_LISTENER::OpenSocket(){
     }
     printf("  ** using file: %s\n", _full_file.c_str());
 
-    struct sockaddr_in serv_addr;
-    socklen_t addr_len = sizeof(serv_addr);
-    _server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    ASSERT(_server_sock >= 0, "Failed to create socket, errno " + decstr(errno));
-
-    memset((char *) &serv_addr, 0, sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_addr.s_addr = INADDR_ANY;
-    serv_addr.sin_port = htons(0); // any port
-
-    /* Now bind the host address using bind() call.*/
-    res = bind(_server_sock, (struct sockaddr *) &serv_addr, sizeof(serv_addr));
-    ASSERT(res >= 0, "bind() failed, errno " + decstr(errno));
+    int fd = open(_full_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    ASSERT(fd >= 0, "Failed to create " + _full_file + ", errno " + decstr(errno));
 
-    res = getsockname(_server_sock, (struct sockaddr *)&serv_addr, &addr_len);
-    ASSERT(0 == res, "getsockname() failed, errno " + decstr(errno));
+    int res = ftruncate(fd, INTERACTIVE_CHANNEL::SIZE);
+    ASSERT(res == 0, "ftruncate() failed, errno " + decstr(errno));
 
-    res = listen(_server_sock, 3);
-    ASSERT(0 == res, "listen() failed, errno " + decstr(errno));
+    VOID* addr = mmap(NULL, INTERACTIVE_CHANNEL::SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    ASSERT(addr != MAP_FAILED, "mmap() failed, errno " + decstr(errno));
+    close(fd);
 
-    printf("  ** listening to port: %d\n", ntohs(serv_addr.sin_port));
-    
-    // writing the used port number to the file in Jason format.
-    // e.g. {port:111}
-    std::fstream fs;
-    fs.open (_full_file.c_str(), std::fstream::out | std::fstream::trunc);
-
-    fs << "{\"port\" : \"" << ntohs(serv_addr.sin_port) << "\"}";
-
-    fs.close();
-    
-    return _server_sock;
-}
+    INTERACTIVE_CHANNEL* channel = static_cast<INTERACTIVE_CHANNEL*>(addr);
+    channel->_ring_size = INTERACTIVE_CHANNEL::RING_SIZE;
+    channel->_pid = pid;
+    channel->_head = 0;
+    //the magic goes last, clients ignore the file until it is there
+    memcpy(channel->_magic, "PINCTRL1", sizeof(channel->_magic));
 
-// After fork,
-// need to create new thread and listen to new fifo file with child pid suffix
-VOID INTERACTIVE_LISTENER::AfterForkInChild(THREADID tid, const CONTEXT* ctxt, void* v){
-    INTERACTIVE_LISTENER* l = static_cast<INTERACTIVE_LISTENER*>(v);
-    close(l->_server_sock); //close the parents file descriptor
-    PIN_SpawnInternalThread(WaitForUserSiganl, l, 0 ,NULL);
+    _next = 0;
+    _channel = channel;
 }
 
-VOID INTERACTIVE_LISTENER::MonitorFD(THREADID tid, CONTEXT *ctxt, SYSCALL_STANDARD std, VOID *v){
-
-     INTERACTIVE_LISTENER* listener = static_cast<INTERACTIVE_LISTENER*>(v);
-     ADDRINT syscall = PIN_GetSyscallNumber(ctxt, std);
-     if (syscall == SYS_close){
-         ADDRINT fd = PIN_GetSyscallArgument(ctxt, std, 0);
-         if (fd == listener->_server_sock){
-             //skip closing controllers fd
-             PIN_SetSyscallArgument(ctxt, std, 0, static_cast<ADDRINT>(-1));
-         }
-     }
+VOID INTERACTIVE_LISTENER::CloseChannel(){
+    INTERACTIVE_CHANNEL* channel = _channel;
+    _channel = NULL;
+    if (channel != NULL){
+        munmap(channel, INTERACTIVE_CHANNEL::SIZE);
+    }
 }
 
-VOID INTERACTIVE_LISTENER::PrepareForFini(VOID* v)
-{
+// After fork the child still maps the parent's channel,
+// need to create a new channel file with the child pid suffix
+VOID INTERACTIVE_LISTENER::AfterForkInChild(THREADID tid, const CONTEXT* ctxt, void* v){
     INTERACTIVE_LISTENER* l = static_cast<INTERACTIVE_LISTENER*>(v);
-    l->_processExiting = TRUE;
+    l->CloseChannel();
+    l->OpenChannel();
 }
 
 VOID INTERACTIVE_LISTENER::Fini(INT32, VOID* v){
     INTERACTIVE_LISTENER* l = static_cast<INTERACTIVE_LISTENER*>(v);
-    close(l->_server_sock);
+    l->CloseChannel();
     unlink(l->_full_file.c_str());
 }
 
-VOID INTERACTIVE_LISTENER::WaitForUserSiganl(VOID* v){
-    /* this function creates the server socket and listens to it.
-     * then it checks if there is info ready to be read from the socket.
-     * once in 0.5 sec we are checking if PIN is exiting in order to 
-     * close the file descriptor and exit the loop.
-     */
-    INTERACTIVE_LISTENER* listener = static_cast<INTERACTIVE_LISTENER*>(v);
-    
-    UINT32 fd = listener->OpenSocket();
-   
-    char buf[1];
-    fd_set rfds;
-    struct timeval tv;
-    int retval;
-
-    /* Wait up to 0.5 seconds. */
-    tv.tv_sec = 0;
-    tv.tv_usec = 500000; //time in microsec.
-
-    while (1){
-        if (listener->_processExiting)
-        {
-            close(fd);
-            return;
-        }
-        FD_ZERO(&rfds);
-        FD_SET(fd, &rfds);
-        memset(buf,0,1);
-        retval = select(fd+1, &rfds, NULL, NULL, &tv);
-        if(retval == -1){
-            ASSERT(FALSE,"error in select function, errno: " + decstr(errno));
-        }
-        else if (retval){
-            struct sockaddr_in cli_addr;
-            socklen_t clilen = sizeof(cli_addr);
-
-            int sessionSock = accept(fd, (struct sockaddr *)&cli_addr, &clilen);
-            if (sessionSock >= 0)
-            {
-                int res = read(sessionSock,buf,1);
-                if (res > 0)
-                {
-                    if(buf[0] == '1')
-                    {
-                        listener->_signaled = 1;
-                    }
-                }
-                close(sessionSock);
-            }
-        }
-    }
-}
-
 #endif
@@ -0,0 +1,74 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*
+ * The main thread calls marker_tick() while the controller has no alarm
+ * armed for it, then waits for a thread that calls marker_go(). That
+ * arms the marker_tick() alarm of the main thread, which moves it from
+ * the idle trace version back to the armed one before it calls
+ * marker_tick() NUM_TICKS more times. The thread calls marker_tick()
+ * too, but the alarm is bound to the main thread.
+ */
+
+#include <pthread.h>
+
+#define NUM_TICKS 5
+
+void marker_tick()
+{
+}
+
+void marker_go()
+{
+}
+
+static void *Go(void *arg)
+{
+    int i;
+    marker_go();
+    for (i = 0; i < NUM_TICKS; i++)
+        marker_tick();
+    return arg;
+}
+
+int main()
+{
+    pthread_t thread;
+    int i;
+
+    for (i = 0; i < NUM_TICKS; i++)
+        marker_tick();
+    if (pthread_create(&thread, 0, Go, 0) != 0)
+        return 1;
+    pthread_join(thread, 0);
+    for (i = 0; i < NUM_TICKS; i++)
+        marker_tick();
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*
+ * Reads the cycle counter and the clocks in the main thread and in two
+ * threads it creates one after the other. It fails when a thread sees
+ * time going backwards or starts before the time its parent read just
+ * before creating it, and prints the time between the reads of every
+ * thread: under -rdtsc_warp and -clock_warp it is the same in every run.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define NUM_THREADS 2
+#define NUM_READS 8
+
+typedef struct
+{
+    unsigned long long created;     /* parent cycles before pthread_create */
+    unsigned long long tsc[NUM_READS];
+    unsigned long long ns[NUM_READS];
+} READS;
+
+static READS reads[NUM_THREADS + 1];
+static volatile unsigned long sink;
+
+static unsigned long long Rdtsc()
+{
+    unsigned int lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+static unsigned long long Nanoseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void Read(READS *r)
+{
+    int i;
+    unsigned long j;
+    for (i = 0; i < NUM_READS; i++)
+    {
+        for (j = 0; j < 1000 * (i + 1); j++)
+            sink += j;
+        r->tsc[i] = Rdtsc();
+        r->ns[i] = Nanoseconds();
+    }
+}
+
+static void *Thread(void *arg)
+{
+    Read((READS *)arg);
+    return 0;
+}
+
+static int Check(int t)
+{
+    READS *r = &reads[t];
+    int i, ok = 1;
+    if (t > 0 && r->tsc[0] <= r->created)
+    {
+        printf("thread %d starts at %llu, before its creation at %llu\n",
+               t, r->tsc[0], r->created);
+        ok = 0;
+    }
+    printf("thread %d:", t);
+    for (i = 1; i < NUM_READS; i++)
+    {
+        if (r->tsc[i] <= r->tsc[i - 1] || r->ns[i] < r->ns[i - 1])
+            ok = 0;
+        printf(" %llu/%llu", r->tsc[i] - r->tsc[i - 1], r->ns[i] - r->ns[i - 1]);
+    }
+    printf(ok ? "\n" : " time goes backwards\n");
+    return ok;
+}
+
+int main()
+{
+    struct timeval tv;
+    pthread_t tid;
+    int t, ok = 1;
+
+    gettimeofday(&tv, 0);
+    printf("time %ld\n", (long)tv.tv_sec);
+
+    Read(&reads[0]);
+    for (t = 1; t <= NUM_THREADS; t++)
+    {
+        reads[t].created = Rdtsc();
+        pthread_create(&tid, 0, Thread, &reads[t]);
+        pthread_join(tid, 0);
+    }
+
+    for (t = 0; t <= NUM_THREADS; t++)
+        ok &= Check(t);
+    return ok ? 0 : 1;
+}
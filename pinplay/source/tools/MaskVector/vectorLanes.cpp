@@ -0,0 +1,487 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+// This tool reports the vector lane utilization of every vector instruction and routine: the vector and
+// element width, the average number of active lanes and, for AVX-512 instructions with a write mask, the
+// fraction of lanes masked out. Scalar SIMD instructions show up with a single active lane, which makes
+// loops that were not vectorized stand out.
+//
+// The mask registers are written into a trace buffer and are popcounted a buffer at a time; instructions
+// without a write mask are counted by one buffer record per execution of their basic block.
+
+#include <cstddef>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include "pin.H"
+extern "C" {
+#include "xed-interface.h"
+}
+
+using std::ofstream;
+using std::cerr;
+using std::vector;
+using std::map;
+using std::setw;
+
+
+/////////////////////
+// TYPES
+/////////////////////
+
+// A vector instruction.
+struct Site
+{
+    ADDRINT pc;
+    UINT32 routine;     // index into routineNames
+    UINT32 vectorBits;  // widest vector register operand
+    UINT32 elementBits;
+    UINT32 lanes;       // elements in the vector
+    UINT32 active;      // lanes used by an unmasked execution: all of them, or 1 for scalar instructions
+    ADDRINT laneMask;   // the mask bits which select lanes of this instruction
+    BOOL masked;        // the lanes are selected by a write mask (k1-k7)
+    string disassembly;
+};
+
+// Execution counts of a vector instruction.
+struct LaneStats
+{
+    UINT64 executions;
+    UINT64 activeLanes;
+    UINT64 idle;        // executions with no active lane
+};
+
+// One trace buffer record: a masked site with its write mask, or a basic block (BLOCK_RECORD set) whose
+// unmasked sites all executed once.
+struct Record
+{
+    ADDRINT mask;
+    UINT32 id;
+};
+
+static const UINT32 BLOCK_RECORD = 0x80000000;
+static const UINT32 NUM_BUF_PAGES = 64;
+
+
+/////////////////////
+// GLOBAL VARIABLES
+/////////////////////
+
+// A knob for defining the output file name
+KNOB<string> KnobOutputFile(KNOB_MODE_WRITEONCE, "pintool", "o", "vectorLanes.out",
+                            "specify file name for vectorLanes output");
+KNOB<UINT32> KnobTop(KNOB_MODE_WRITEONCE, "pintool", "top", "50",
+                     "number of instructions and routines in the report");
+
+// ofstream object for handling the output.
+ofstream OutFile;
+
+// Tables filled at instrumentation time and read by the buffer processing of all threads.
+PIN_LOCK tablesLock;
+vector<Site> sites;
+vector<vector<UINT32> > blocks;         // unmasked sites of a basic block
+vector<string> routineNames;
+map<string, UINT32> routineIds;
+
+BUFFER_ID bufId;
+
+// Per-thread execution counts, indexed by site.
+vector<LaneStats>* threadStats[PIN_MAX_THREADS];
+
+
+/////////////////////
+// UTILITY FUNCTIONS
+/////////////////////
+
+static int Usage()
+{
+    cerr << "This tool reports the vector lane utilization of every vector instruction and routine." << endl <<
+            endl << KNOB_BASE::StringKnobSummary() << endl;
+    return 1;
+}
+
+static UINT32 PopCount(UINT64 x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<UINT32>((x * 0x0101010101010101ULL) >> 56);
+}
+
+// Caller must hold tablesLock
+static UINT32 RoutineId(ADDRINT pc)
+{
+    string name = RTN_FindNameByAddress(pc);
+    if (name.empty()) name = "<unknown>";
+
+    map<string, UINT32>::iterator it = routineIds.find(name);
+    if (it != routineIds.end()) return it->second;
+
+    const UINT32 id = routineNames.size();
+    routineNames.push_back(name);
+    routineIds[name] = id;
+    return id;
+}
+
+// Find the widest vector register operand of the instruction, return its operand index or -1.
+static INT32 GetVectorOperand(xed_decoded_inst_t const* const xedd, xed_inst_t const* const xedi,
+                              UINT32& vectorBits)
+{
+    INT32 vectorOperand = -1;
+    vectorBits = 0;
+    const UINT32 operandCount = xed_inst_noperands(xedi);
+    for (UINT32 operandNum = 0; operandNum < operandCount; ++operandNum)
+    {
+        const xed_operand_enum_t op_name = xed_operand_name(xed_inst_operand(xedi, operandNum));
+        if (!xed_operand_is_register(op_name)) continue;
+
+        UINT32 bits = 0;
+        switch (xed_reg_class(xed_decoded_inst_get_reg(xedd, op_name)))
+        {
+          case XED_REG_CLASS_XMM: bits = 128; break;
+          case XED_REG_CLASS_YMM: bits = 256; break;
+          case XED_REG_CLASS_ZMM: bits = 512; break;
+          default: break;
+        }
+        if (bits > vectorBits)
+        {
+            vectorBits = bits;
+            vectorOperand = operandNum;
+        }
+    }
+    return vectorOperand;
+}
+
+// The write mask register of an AVX-512 instruction, or XED_REG_INVALID. Operand 0 is skipped for
+// instructions which write a mask, like vpcmpd; k0 selects all the lanes.
+static xed_reg_enum_t GetWriteMask(xed_decoded_inst_t const* const xedd, xed_inst_t const* const xedi)
+{
+    const UINT32 operandCount = xed_inst_noperands(xedi);
+    for (UINT32 operandNum = 1; operandNum < operandCount; ++operandNum)
+    {
+        xed_operand_t const* const operand = xed_inst_operand(xedi, operandNum);
+        const xed_operand_enum_t op_name = xed_operand_name(operand);
+        if (!xed_operand_is_register(op_name) || !xed_operand_read(operand)) continue;
+
+        xed_reg_enum_t reg = xed_decoded_inst_get_reg(xedd, op_name);
+        if (XED_REG_CLASS_MASK != xed_reg_class(reg)) continue;
+        return (XED_REG_K0 == reg) ? XED_REG_INVALID : reg;
+    }
+    return XED_REG_INVALID;
+}
+
+
+/////////////////////
+// ANALYSIS FUNCTIONS
+/////////////////////
+
+// Process a full buffer of a thread: popcount the masks and count the blocks' unmasked sites.
+static VOID* BufferFull(BUFFER_ID id, THREADID tid, const CONTEXT* ctxt, VOID* buf, UINT64 numElements, VOID* v)
+{
+    vector<LaneStats>& stats = *threadStats[tid];
+    const Record* records = static_cast<const Record*>(buf);
+
+    PIN_GetLock(&tablesLock, tid + 1);
+    if (stats.size() < sites.size())
+    {
+        LaneStats empty = { 0, 0, 0 };
+        stats.resize(sites.size(), empty);
+    }
+    for (UINT64 i = 0; i < numElements; ++i)
+    {
+        const Record& r = records[i];
+        if (r.id & BLOCK_RECORD)
+        {
+            const vector<UINT32>& unmasked = blocks[r.id & ~BLOCK_RECORD];
+            for (UINT32 s = 0; s < unmasked.size(); ++s)
+            {
+                LaneStats& ls = stats[unmasked[s]];
+                ++ls.executions;
+                ls.activeLanes += sites[unmasked[s]].active;
+            }
+        }
+        else
+        {
+            const UINT32 active = PopCount(r.mask & sites[r.id].laneMask);
+            LaneStats& ls = stats[r.id];
+            ++ls.executions;
+            ls.activeLanes += active;
+            ls.idle += (0 == active);
+        }
+    }
+    PIN_ReleaseLock(&tablesLock);
+    return buf;
+}
+
+
+/////////////////////
+// INSTRUMENTATION FUNCTIONS
+/////////////////////
+
+// Add a site for a vector instruction, return its id or -1 for other instructions.
+// Caller must hold tablesLock
+static INT32 AddSite(INS ins, xed_reg_enum_t& writeMask)
+{
+    xed_decoded_inst_t const* const xedd = INS_XedDec(ins);
+    xed_inst_t const* const xedi = xed_decoded_inst_inst(xedd);
+
+    Site site;
+    const INT32 vectorOperand = GetVectorOperand(xedd, xedi, site.vectorBits);
+    if (vectorOperand < 0) return -1;
+
+    site.elementBits = xed_decoded_inst_operand_element_size_bits(xedd, vectorOperand);
+    site.lanes = (0 == site.elementBits) ? 1 : site.vectorBits / site.elementBits;
+    site.active = site.lanes;
+    if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_SIMD_SCALAR)) site.active = 1;
+    site.laneMask = (site.active >= 64) ? ~ADDRINT(0) : ((ADDRINT(1) << site.active) - 1);
+
+    writeMask = GetWriteMask(xedd, xedi);
+    site.masked = (XED_REG_INVALID != writeMask);
+    site.pc = INS_Address(ins);
+    site.routine = RoutineId(site.pc);
+    site.disassembly = INS_Disassemble(ins);
+
+    sites.push_back(site);
+    return sites.size() - 1;
+}
+
+static VOID Trace(TRACE trace, VOID* v)
+{
+    PIN_GetLock(&tablesLock, 1);
+    for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+    {
+        vector<UINT32> unmasked;
+        for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+        {
+            xed_reg_enum_t writeMask = XED_REG_INVALID;
+            const INT32 id = AddSite(ins, writeMask);
+            if (id < 0) continue;
+
+            if (XED_REG_INVALID == writeMask)
+            {
+                unmasked.push_back(id);
+                continue;
+            }
+            // only the executed instances of predicated instructions are counted
+            INS_InsertFillBufferPredicated(ins, IPOINT_BEFORE, bufId,
+                                           IARG_REG_VALUE, REG(REG_K0 + (writeMask - XED_REG_K0)),
+                                           offsetof(Record, mask),
+                                           IARG_UINT32, UINT32(id), offsetof(Record, id),
+                                           IARG_END);
+        }
+        if (unmasked.empty()) continue;
+
+        INS_InsertFillBuffer(BBL_InsHead(bbl), IPOINT_BEFORE, bufId,
+                             IARG_ADDRINT, ADDRINT(0), offsetof(Record, mask),
+                             IARG_UINT32, UINT32(blocks.size() | BLOCK_RECORD), offsetof(Record, id),
+                             IARG_END);
+        blocks.push_back(unmasked);
+    }
+    PIN_ReleaseLock(&tablesLock);
+}
+
+
+/////////////////////
+// CALLBACKS
+/////////////////////
+
+static VOID ThreadStart(THREADID tid, CONTEXT* ctxt, INT32 flags, VOID* v)
+{
+    ASSERTX(tid < PIN_MAX_THREADS);
+    if (0 == threadStats[tid]) threadStats[tid] = new vector<LaneStats>;
+}
+
+static double Percent(UINT64 part, UINT64 total)
+{
+    return (0 == total) ? 0.0 : 100.0 * (double)part / (double)total;
+}
+
+// Sort by the number of idle lane slots, which is what vectorizing the code better would recover.
+struct ByIdleLanes
+{
+    const vector<UINT64>* idleLanes;
+    bool operator()(UINT32 a, UINT32 b) const
+    {
+        return (*idleLanes)[a] > (*idleLanes)[b] || ((*idleLanes)[a] == (*idleLanes)[b] && a < b);
+    }
+};
+
+static VOID Fini(INT32 code, VOID* v)
+{
+    // merge the threads; their last buffers were processed when they exited
+    LaneStats empty = { 0, 0, 0 };
+    vector<LaneStats> total(sites.size(), empty);
+    for (UINT32 t = 0; t < PIN_MAX_THREADS; ++t)
+    {
+        if (0 == threadStats[t]) continue;
+        const vector<LaneStats>& stats = *threadStats[t];
+        for (UINT32 s = 0; s < stats.size(); ++s)
+        {
+            total[s].executions += stats[s].executions;
+            total[s].activeLanes += stats[s].activeLanes;
+            total[s].idle += stats[s].idle;
+        }
+    }
+
+    // the same instruction may have been instrumented in several traces
+    map<ADDRINT, UINT32> byPc;
+    vector<LaneStats> pcStats;
+    vector<UINT32> pcSite;
+    vector<LaneStats> routineStats(routineNames.size(), empty);
+    vector<UINT64> routineLanes(routineNames.size(), 0);
+    UINT64 executions = 0, lanes = 0, active = 0;
+    for (UINT32 s = 0; s < sites.size(); ++s)
+    {
+        if (0 == total[s].executions) continue;
+        map<ADDRINT, UINT32>::iterator it = byPc.find(sites[s].pc);
+        if (it == byPc.end())
+        {
+            it = byPc.insert(std::make_pair(sites[s].pc, UINT32(pcStats.size()))).first;
+            pcStats.push_back(empty);
+            pcSite.push_back(s);
+        }
+        LaneStats& ps = pcStats[it->second];
+        ps.executions += total[s].executions;
+        ps.activeLanes += total[s].activeLanes;
+        ps.idle += total[s].idle;
+
+        LaneStats& rs = routineStats[sites[s].routine];
+        rs.executions += total[s].executions;
+        rs.activeLanes += total[s].activeLanes;
+        rs.idle += total[s].idle;
+        routineLanes[sites[s].routine] += total[s].executions * sites[s].lanes;
+
+        executions += total[s].executions;
+        lanes += total[s].executions * sites[s].lanes;
+        active += total[s].activeLanes;
+    }
+
+    OutFile << "# vectorLanes: " << executions << " vector instructions executed, lane utilization "
+            << std::fixed << std::setprecision(2) << Percent(active, lanes) << "%" << endl;
+
+    vector<UINT64> idleLanes(pcStats.size());
+    vector<UINT32> order(pcStats.size());
+    for (UINT32 p = 0; p < pcStats.size(); ++p)
+    {
+        idleLanes[p] = pcStats[p].executions * sites[pcSite[p]].lanes - pcStats[p].activeLanes;
+        order[p] = p;
+    }
+    ByIdleLanes byIdle = { &idleLanes };
+    std::sort(order.begin(), order.end(), byIdle);
+
+    OutFile << "#" << endl << "# instructions by idle lanes" << endl
+            << "#                pc      executions  width  elem  lanes  avg active  util%  masked-out%  "
+               "routine: instruction" << endl;
+    for (UINT32 i = 0; i < order.size() && i < KnobTop; ++i)
+    {
+        const LaneStats& ps = pcStats[order[i]];
+        const Site& site = sites[pcSite[order[i]]];
+        const UINT64 slots = ps.executions * site.lanes;
+        OutFile << "0x" << std::hex << setw(16) << std::setfill('0') << site.pc << std::dec << std::setfill(' ')
+                << "  " << setw(14) << ps.executions
+                << "  " << setw(5) << site.vectorBits
+                << "  " << setw(4) << site.elementBits
+                << "  " << setw(5) << site.lanes
+                << "  " << setw(10) << (double)ps.activeLanes / (double)ps.executions
+                << "  " << setw(5) << Percent(ps.activeLanes, slots) << "  ";
+        if (site.masked)
+        {
+            // of the lanes the mask selects from
+            const UINT64 selectable = ps.executions * site.active;
+            OutFile << setw(11) << Percent(selectable - ps.activeLanes, selectable);
+        }
+        else
+        {
+            OutFile << setw(11) << "-";
+        }
+        OutFile << "  " << routineNames[site.routine] << ": " << site.disassembly << endl;
+    }
+
+    vector<UINT64> routineIdle(routineNames.size());
+    vector<UINT32> routineOrder;
+    for (UINT32 r = 0; r < routineNames.size(); ++r)
+    {
+        routineIdle[r] = routineLanes[r] - routineStats[r].activeLanes;
+        if (routineStats[r].executions) routineOrder.push_back(r);
+    }
+    ByIdleLanes byRoutineIdle = { &routineIdle };
+    std::sort(routineOrder.begin(), routineOrder.end(), byRoutineIdle);
+
+    OutFile << "#" << endl << "# routines by idle lanes" << endl
+            << "#    executions  avg active  util%  idle%  routine" << endl;
+    for (UINT32 i = 0; i < routineOrder.size() && i < KnobTop; ++i)
+    {
+        const UINT32 r = routineOrder[i];
+        const LaneStats& rs = routineStats[r];
+        OutFile << setw(15) << rs.executions
+                << "  " << setw(10) << (double)rs.activeLanes / (double)rs.executions
+                << "  " << setw(5) << Percent(rs.activeLanes, routineLanes[r])
+                << "  " << setw(5) << Percent(rs.idle, rs.executions)
+                << "  " << routineNames[r] << endl;
+    }
+    OutFile.close();
+}
+
+
+/////////////////////
+// MAIN FUNCTION
+/////////////////////
+
+int main(int argc, char * argv[])
+{
+    // Initialize pin
+    PIN_InitSymbols();
+    if (PIN_Init(argc, argv)) return Usage();
+
+    OutFile.open(KnobOutputFile.Value().c_str());
+    PIN_InitLock(&tablesLock);
+
+    bufId = PIN_DefineTraceBuffer(sizeof(Record), NUM_BUF_PAGES, BufferFull, 0);
+    if (BUFFER_ID_INVALID == bufId)
+    {
+        cerr << "Error: could not allocate initial buffer" << endl;
+        return 1;
+    }
+
+    // Register Trace to be called to instrument instructions
+    TRACE_AddInstrumentFunction(Trace, 0);
+    PIN_AddThreadStartFunction(ThreadStart, 0);
+
+    // Register Fini to be called when the application exits
+    PIN_AddFiniFunction(Fini, 0);
+
+    // Start the program, never returns
+    PIN_StartProgram();
+
+    return 0;
+}
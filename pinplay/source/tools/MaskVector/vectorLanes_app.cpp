@@ -0,0 +1,72 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+// This application runs a packed and a scalar double-precision SSE2 loop.
+// The application is used with vectorLanes.cpp.
+
+#include <emmintrin.h>
+
+static double a[1024];
+static double b[1024];
+volatile double sink;
+
+int main()
+{
+    for (int i = 0; i < 1024; ++i)
+    {
+        a[i] = i;
+        b[i] = 2 * i;
+    }
+
+    // two active lanes
+    __m128d packed = _mm_setzero_pd();
+    for (int r = 0; r < 100; ++r)
+    {
+        for (int i = 0; i < 1024; i += 2)
+        {
+            packed = _mm_add_pd(packed, _mm_loadu_pd(&a[i]));
+        }
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, packed);
+
+    // one active lane
+    __m128d scalar = _mm_setzero_pd();
+    for (int r = 0; r < 100; ++r)
+    {
+        for (int i = 0; i < 1024; ++i)
+        {
+            scalar = _mm_add_sd(scalar, _mm_load_sd(&b[i]));
+        }
+    }
+
+    sink = lanes[0] + lanes[1] + _mm_cvtsd_f64(scalar);
+    return 0;
+}
@@ -46,6 +46,7 @@ END_LEGAL */
 
 #include "pin.H"
 #include "portability.H"
+#include "overhead_stats.H"
 using namespace std;
 
 
@@ -63,6 +64,11 @@ KNOB<string> KnobOutputFile(KNOB_MODE_WRITEONCE, "pintool", "o", "membuffer.out"
  */
 KNOB<BOOL> KnobEmitTrace(KNOB_MODE_WRITEONCE, "pintool", "emit", "0", "emit a trace in the output file");
 
+/*
+ * Overhead statistics for the benchmarks (-overhead_stats)
+ */
+INSTLIB::OVERHEAD_STATS overheadStats;
+
 
 
 /* Struct for holding memory references.
@@ -255,6 +261,7 @@ int main(int argc, char *argv[])
     {
         return Usage();
     }
+    overheadStats.Activate();
     
     // Initialize the memory reference buffer
     bufId = PIN_DefineTraceBuffer(sizeof(struct MEMREF), NUM_BUF_PAGES,
@@ -51,6 +51,7 @@ END_LEGAL */
 
 #include "pin.H"
 #include "portability.H"
+#include "overhead_stats.H"
 using namespace std;
 
 
@@ -63,6 +64,9 @@ KNOB<BOOL> KnobProcessBuffer(KNOB_MODE_WRITEONCE, "pintool", "process_buffs", "1
 // 256*4096=1048576 - same size buffer in memtrace_simple, membuffer_simple, membuffer_multi
 KNOB<UINT32> KnobNumPagesInBuffer(KNOB_MODE_WRITEONCE, "pintool", "num_pages_in_buffer", "256", "number of pages in buffer");
 
+// overhead statistics for the benchmarks (-overhead_stats)
+INSTLIB::OVERHEAD_STATS overheadStats;
+
 
 /* Struct of memory reference written to the buffer
  */
@@ -254,6 +258,7 @@ int main(int argc, char *argv[])
     {
         return Usage();
     }
+    overheadStats.Activate();
     
     // Initialize the memory reference buffer
     //printf ("buffer size in bytes 0x%x\n", KnobNumPagesInBuffer.Value()*4096);
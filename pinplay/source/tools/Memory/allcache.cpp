@@ -35,6 +35,9 @@ END_LEGAL */
 /*! @file
  *  This file contains an ISA-portable PIN tool for functional simulation of
  *  instruction+data TLB+cache hieraries
+ *
+ *  The TLBs model 4K, 2M and 1G pages with a shared second level TLB and
+ *  count page walks; huge page mappings are taken from /proc/self/smaps.
  */
 
 #include <iostream>
@@ -44,36 +47,28 @@ END_LEGAL */
 typedef UINT32 CACHE_STATS; // type of cache hit/miss counters
 
 #include "pin_cache.H"
+#include "tlb.H"
+#include "overhead_stats.H"
 
-namespace ITLB
-{
-    // instruction TLB: 4 kB pages, 32 entries, fully associative
-    const UINT32 lineSize = 4*KILO;
-    const UINT32 cacheSize = 32 * lineSize;
-    const UINT32 associativity = 32;
-    const CACHE_ALLOC::STORE_ALLOCATION allocation = CACHE_ALLOC::STORE_ALLOCATE;
+KNOB<string> KnobTlbPageSize(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_page_size", "4k", "page size (4k, 2m or 1g) for addresses not known to be huge page backed");
+KNOB<BOOL> KnobTlbSmaps(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_smaps", "1", "infer huge page mappings from /proc/self/smaps");
+KNOB<UINT32> KnobTlbSmapsWalks(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_smaps_walks", "100000", "also re-read /proc/self/smaps after this many page walks (0 for never)");
 
-    const UINT32 max_sets = cacheSize / (lineSize * associativity);
-    const UINT32 max_associativity = associativity;
+// page sizes of the application's mappings
+LOCALVAR TLB_PAGE_MAP pageMap;
 
-    typedef CACHE_ROUND_ROBIN(max_sets, max_associativity, allocation) CACHE;
-}
-LOCALFUN ITLB::CACHE itlb("ITLB", ITLB::cacheSize, ITLB::lineSize, ITLB::associativity);
+LOCALVAR INSTLIB::OVERHEAD_STATS overheadStats;
 
-namespace DTLB
-{
-    // data TLB: 4 kB pages, 32 entries, fully associative
-    const UINT32 lineSize = 4*KILO;
-    const UINT32 cacheSize = 32 * lineSize;
-    const UINT32 associativity = 32;
-    const CACHE_ALLOC::STORE_ALLOCATION allocation = CACHE_ALLOC::STORE_ALLOCATE;
-
-    const UINT32 max_sets = cacheSize / (lineSize * associativity);
-    const UINT32 max_associativity = associativity;
-
-    typedef CACHE_ROUND_ROBIN(max_sets, max_associativity, allocation) CACHE;
-}
-LOCALVAR DTLB::CACHE dtlb("DTLB", DTLB::cacheSize, DTLB::lineSize, DTLB::associativity);
+// instruction and data TLBs with their own first levels and a shared STLB;
+// one buffer for both keeps the STLB accesses in order
+LOCALVAR TLB_HIERARCHY itlb("ITLB", pageMap);
+LOCALVAR TLB_HIERARCHY dtlb("DTLB", pageMap, TLB_CONFIG(), &itlb);
+LOCALVAR TLB_SHARED_BUFFER tlbBuffer;
+LOCALVAR UINT32 itlbIndex;
+LOCALVAR UINT32 dtlbIndex;
 
 namespace IL1
 {
@@ -135,6 +130,8 @@ LOCALVAR UL3::CACHE ul3("L3 Unified Cache", UL3::cacheSize, UL3::lineSize, UL3::
 
 LOCALFUN VOID Fini(int code, VOID * v)
 {
+    tlbBuffer.Drain();
+
     std::cerr << itlb;
     std::cerr << dtlb;
     std::cerr << il1;
@@ -143,6 +140,11 @@ LOCALFUN VOID Fini(int code, VOID * v)
     std::cerr << ul3;
 }
 
+LOCALFUN VOID ImageLoad(IMG img, VOID *v)
+{
+    pageMap.MarkStale();
+}
+
 LOCALFUN VOID Ul2Access(ADDRINT addr, UINT32 size, CACHE_BASE::ACCESS_TYPE accessType)
 {
     // second level unified cache
@@ -158,7 +160,7 @@ LOCALFUN VOID InsRef(ADDRINT addr)
     const CACHE_BASE::ACCESS_TYPE accessType = CACHE_BASE::ACCESS_TYPE_LOAD;
 
     // ITLB
-    itlb.AccessSingleLine(addr, accessType);
+    tlbBuffer.Buffer(itlbIndex, addr);
 
     // first level I-cache
     const BOOL il1Hit = il1.AccessSingleLine(addr, accessType);
@@ -170,7 +172,7 @@ LOCALFUN VOID InsRef(ADDRINT addr)
 LOCALFUN VOID MemRefMulti(ADDRINT addr, UINT32 size, CACHE_BASE::ACCESS_TYPE accessType)
 {
     // DTLB
-    dtlb.AccessSingleLine(addr, CACHE_BASE::ACCESS_TYPE_LOAD);
+    tlbBuffer.Buffer(dtlbIndex, addr);
 
     // first level D-cache
     const BOOL dl1Hit = dl1.Access(addr, size, accessType);
@@ -182,7 +184,7 @@ LOCALFUN VOID MemRefMulti(ADDRINT addr, UINT32 size, CACHE_BASE::ACCESS_TYPE acc
 LOCALFUN VOID MemRefSingle(ADDRINT addr, UINT32 size, CACHE_BASE::ACCESS_TYPE accessType)
 {
     // DTLB
-    dtlb.AccessSingleLine(addr, CACHE_BASE::ACCESS_TYPE_LOAD);
+    tlbBuffer.Buffer(dtlbIndex, addr);
 
     // first level D-cache
     const BOOL dl1Hit = dl1.AccessSingleLine(addr, accessType);
@@ -231,6 +233,23 @@ LOCALFUN VOID Instruction(INS ins, VOID *v)
 GLOBALFUN int main(int argc, char *argv[])
 {
     PIN_Init(argc, argv);
+    overheadStats.Activate();
+
+    TLB_PAGE::SIZE pageSize;
+    if (!TLB_PAGE::Parse(KnobTlbPageSize.Value(), pageSize))
+    {
+        std::cerr << "allcache: bad -tlb_page_size " << KnobTlbPageSize.Value() << std::endl;
+        return 1;
+    }
+    pageMap.SetDefault(pageSize);
+    if (KnobTlbSmaps)
+    {
+        pageMap.Follow("/proc/self/smaps", KnobTlbSmapsWalks);
+        pageMap.TrackMappingSyscalls();
+        IMG_AddInstrumentFunction(ImageLoad, 0);
+    }
+    itlbIndex = tlbBuffer.Add(&itlb);
+    dtlbIndex = tlbBuffer.Add(&dtlb);
 
     INS_AddInstrumentFunction(Instruction, 0);
     PIN_AddFiniFunction(Fini, 0);
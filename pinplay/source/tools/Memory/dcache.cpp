@@ -46,6 +46,7 @@ END_LEGAL */
 #include <cassert>
 
 #include "cache.H"
+#include "tlb.H"
 #include "pin_profile.H"
 
 
@@ -69,6 +70,14 @@ KNOB<UINT32> KnobLineSize(KNOB_MODE_WRITEONCE, "pintool",
     "b","32", "cache block size in bytes");
 KNOB<UINT32> KnobAssociativity(KNOB_MODE_WRITEONCE, "pintool",
     "a","4", "cache associativity (1 for direct mapped)");
+KNOB<BOOL>   KnobTlb(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb", "0", "also simulate a multi-level data TLB with page walks");
+KNOB<string> KnobTlbPageSize(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_page_size", "4k", "page size (4k, 2m or 1g) for addresses not known to be huge page backed");
+KNOB<BOOL>   KnobTlbSmaps(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_smaps", "1", "infer huge page mappings from /proc/self/smaps");
+KNOB<UINT32> KnobTlbSmapsWalks(KNOB_MODE_WRITEONCE, "pintool",
+    "tlb_smaps_walks", "100000", "also re-read /proc/self/smaps after this many page walks (0 for never)");
 
 /* ===================================================================== */
 
@@ -101,6 +110,10 @@ namespace DL1
 
 DL1::CACHE* dl1 = NULL;
 
+// page sizes of the application's mappings and the data TLB using them
+TLB_PAGE_MAP pageMap;
+TLB_HIERARCHY* dtlb = NULL;
+
 typedef enum
 {
     COUNTER_MISS = 0,
@@ -192,6 +205,20 @@ VOID StoreSingleFast(ADDRINT addr)
 
 
 
+/* ===================================================================== */
+
+VOID TlbRef(ADDRINT addr)
+{
+    dtlb->Buffer(addr);
+}
+
+/* ===================================================================== */
+
+VOID ImageLoad(IMG img, VOID * v)
+{
+    pageMap.MarkStale();
+}
+
 /* ===================================================================== */
 
 VOID Instruction(INS ins, void * v)
@@ -206,6 +233,14 @@ VOID Instruction(INS ins, void * v)
     {
         const UINT32 size = INS_MemoryOperandSize(ins, memOp);
         const BOOL   single = (size <= 4);
+
+        if (dtlb)
+        {
+            INS_InsertPredicatedCall(
+                ins, IPOINT_BEFORE, (AFUNPTR) TlbRef,
+                IARG_MEMORYOP_EA, memOp,
+                IARG_END);
+        }
         
         if (INS_MemoryOperandIsRead(ins, memOp))
         {
@@ -321,6 +356,17 @@ VOID Fini(int code, VOID * v)
     
     out << dl1->StatsLong("# ", CACHE_BASE::CACHE_TYPE_DCACHE);
 
+    if (dtlb) {
+        dtlb->Drain();
+
+        out <<
+            "#\n"
+            "# DTLB stats\n"
+            "#\n";
+
+        out << dtlb->StatsLong("# ");
+    }
+
     if( KnobTrackLoads || KnobTrackStores ) {
         out <<
             "#\n"
@@ -348,6 +394,24 @@ int main(int argc, char *argv[])
                          KnobLineSize.Value(),
                          KnobAssociativity.Value());
     
+    if (KnobTlb)
+    {
+        TLB_PAGE::SIZE pageSize;
+        if (!TLB_PAGE::Parse(KnobTlbPageSize.Value(), pageSize))
+        {
+            return Usage();
+        }
+        pageMap.SetDefault(pageSize);
+        dtlb = new TLB_HIERARCHY("DTLB", pageMap);
+
+        if (KnobTlbSmaps)
+        {
+            pageMap.Follow("/proc/self/smaps", KnobTlbSmapsWalks);
+            pageMap.TrackMappingSyscalls();
+            IMG_AddInstrumentFunction(ImageLoad, 0);
+        }
+    }
+
     profile.SetKeyName("iaddr          ");
     profile.SetCounterName("dcache:miss        dcache:hit");
 
@@ -0,0 +1,66 @@
+/*BEGIN_LEGAL 
+Intel Open Source License 
+
+Copyright (c) 2002-2016 Intel Corporation. All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.  Redistributions
+in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.  Neither the name of
+the Intel Corporation nor the names of its contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE INTEL OR
+ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+END_LEGAL */
+/*
+ * The main thread loads every 16B chunk of a 64KB buffer, then a second
+ * thread stores to every chunk of it: footprint must count the buffer as
+ * load only in the first thread, store only in the second and load+store
+ * in the global summary.
+ */
+#include <stdio.h>
+#include "../Utils/threadlib.h"
+
+#define BUFFER_SIZE 0x10000
+#define CHUNK_SIZE 16
+
+volatile char buffer[BUFFER_SIZE];
+
+void *store(void *arg)
+{
+    for (int i = 0; i < BUFFER_SIZE; i += CHUNK_SIZE)
+        buffer[i] = 1;
+    return 0;
+}
+
+int main()
+{
+    int sum = 0;
+    for (int i = 0; i < BUFFER_SIZE; i += CHUNK_SIZE)
+        sum += buffer[i];
+
+    THREAD_HANDLE thread;
+    if (!CreateOneThread(&thread, store, 0) || !JoinOneThread(thread))
+    {
+        fprintf(stderr, "cannot run the store thread\n");
+        return 1;
+    }
+    printf("sum %d\n", sum);
+    return 0;
+}
@@ -42,6 +42,7 @@ END_LEGAL */
 
 #include "pin.H"
 #include "control_manager.H"
+#include "overhead_stats.H"
 #include "portability.H"
 #include <vector>
 #include <iostream>
@@ -543,6 +544,7 @@ VOID zero_stats(THREADID tid); //forward prototype
 VOID Fini(int, VOID * v);
 VOID emit_bbl_stats_sorted(THREADID tid);
 LOCALVAR CONTROL_MANAGER control;
+LOCALVAR INSTLIB::OVERHEAD_STATS overheadStats;
 
 
 
@@ -1418,6 +1420,7 @@ int main(int argc, CHAR **argv)
     PIN_InitSymbols();
     if( PIN_Init(argc,argv) )
         return Usage();
+    overheadStats.Activate();
 
     PIN_InitLock(&locks.lock);
     PIN_InitLock(&locks.bbl_list_lock);
@@ -39,6 +39,7 @@ END_LEGAL */
  */
 
 #include "pin.H"
+#include "overhead_stats.H"
 #include <iostream>
 
 /* ===================================================================== */
@@ -47,6 +48,8 @@ END_LEGAL */
 
 UINT64 ins_count = 0;
 
+INSTLIB::OVERHEAD_STATS overheadStats;
+
 /* ===================================================================== */
 /* Commandline Switches */
 /* ===================================================================== */
@@ -101,7 +104,7 @@ int main(int argc, char *argv[])
     {
         return Usage();
     }
-    
+    overheadStats.Activate();
 
     INS_AddInstrumentFunction(Instruction, 0);
     PIN_AddFiniFunction(Fini, 0);